@@ -0,0 +1,74 @@
+//============================================================================
+// Name        : Arena.cpp
+// Author      : Tobias Wilfert
+//============================================================================
+
+#include "Arena.h"
+
+#include <cstdint>
+#include <algorithm>
+
+CYK::Arena::Arena(std::size_t initialSize)
+    : initialSize(std::max<std::size_t>(initialSize, 1024)) {}
+
+void *CYK::Arena::do_allocate(std::size_t bytes, std::size_t alignment) {
+  for(;;){
+    if(block < blocks.size()){
+      Block& current = blocks[block];
+      auto base = reinterpret_cast<std::uintptr_t>(current.data.get());
+      std::uintptr_t begin = (base + used + alignment - 1) &
+                             ~static_cast<std::uintptr_t>(alignment - 1);
+      if(begin + bytes <= base + current.size){
+        used = begin + bytes - base;
+        return reinterpret_cast<void*>(begin);
+      }
+      if(block + 1 < blocks.size() &&
+         blocks[block + 1].size >= bytes + alignment){
+        ++block;
+        used = 0;
+        continue;
+      }
+      // The free blocks after this one are too small, replace them
+      blocks.resize(block + 1);
+    }
+    std::size_t size = blocks.empty() ? initialSize : blocks.back().size * 2;
+    size = std::max(size, bytes + alignment);
+    const std::size_t units = (size + sizeof(std::max_align_t) - 1) /
+                              sizeof(std::max_align_t);
+    blocks.push_back({std::make_unique<std::max_align_t[]>(units),
+                      units * sizeof(std::max_align_t)});
+    block = blocks.size() - 1;
+    used = 0;
+  }
+}
+
+void CYK::Arena::do_deallocate(void *, std::size_t, std::size_t) {}
+
+bool CYK::Arena::do_is_equal(
+    const std::pmr::memory_resource &other) const noexcept {
+  return this == &other;
+}
+
+CYK::Arena::Mark CYK::Arena::mark() const {
+  return {block, used};
+}
+
+void CYK::Arena::rewind(const CYK::Arena::Mark &mark) {
+  block = mark.block;
+  used = mark.used;
+}
+
+void CYK::Arena::reset() {
+  rewind({});
+}
+
+void CYK::Arena::release() {
+  blocks.clear();
+  reset();
+}
+
+std::size_t CYK::Arena::getCapacity() const {
+  std::size_t capacity = 0;
+  for(auto& current: blocks){ capacity += current.size; }
+  return capacity;
+}
@@ -0,0 +1,91 @@
+//============================================================================
+// Name        : Arena.h
+// Author      : Tobias Wilfert
+//============================================================================
+
+#ifndef CYK__ARENA_H_
+#define CYK__ARENA_H_
+
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include <memory_resource>
+
+namespace CYK{
+
+/**
+ * A monotonic allocator for the storage of a single parse
+ *
+ * Allocating bumps a pointer through large blocks and deallocating does
+ * nothing; everything allocated after a mark is freed at once by rewinding
+ * to the mark, which only resets the pointer. The blocks are kept, so the
+ * next parse on the same arena does not allocate from the heap at all once
+ * the blocks are large enough. Every ParserContext has its own arena for the
+ * cells of its Table, so parser threads never contend for the heap for them.
+ *
+ * It is a std::pmr::memory_resource, std::pmr containers can use it.
+ */
+class Arena : public std::pmr::memory_resource {
+ public:
+  /// A position in the arena to rewind to
+  struct Mark {
+    std::size_t block = 0;
+    std::size_t used = 0;
+  };
+
+ private:
+  /// A block the allocations are taken from
+  struct Block {
+    std::unique_ptr<std::max_align_t[]> data;
+    std::size_t size;
+  };
+
+  /// The blocks, the ones after block are free
+  std::vector<Block> blocks;
+
+  /// The block that is allocated from and the bytes used in it
+  std::size_t block = 0;
+  std::size_t used = 0;
+
+  /// The size of the first block
+  std::size_t initialSize;
+
+ protected:
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+
+  /// Does nothing, the memory is freed by rewind
+  void do_deallocate(void* pointer, std::size_t bytes,
+                     std::size_t alignment) override;
+
+  bool do_is_equal(const std::pmr::memory_resource& other)
+      const noexcept override;
+
+ public:
+  /// @param initialSize The size of the first block, later ones double
+  explicit Arena(std::size_t initialSize = 64 << 10);
+
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  /// @return The current position
+  Mark mark() const;
+
+  /**
+   * Frees everything allocated since a mark, in constant time
+   * @param mark A mark taken after the last rewind to an earlier position
+   */
+  void rewind(const Mark& mark);
+
+  /// Frees everything allocated, the blocks are kept for reuse
+  void reset();
+
+  /// Frees everything allocated and returns the blocks to the heap
+  void release();
+
+  /// @return The bytes of all blocks
+  std::size_t getCapacity() const;
+};
+
+} // namespace CYK
+
+#endif//CYK__ARENA_H_
@@ -0,0 +1,70 @@
+//============================================================================
+// Name        : BatchParser.cpp
+// Author      : Tobias Wilfert
+//============================================================================
+
+#include "BatchParser.h"
+
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include <exception>
+
+#include "Trace.h"
+#include "BitsetParser.h"
+
+CYK::BatchParser::BatchParser(const CYK::ContextFreeGrammar &grammar,
+                              unsigned int threads, CYK::ResultCache *cache)
+    : grammar(grammar), threads(std::max(threads, 1u)), cache(cache) {}
+
+std::vector<char> CYK::BatchParser::recognize(
+    const std::vector<std::string> &inputs, CYK::OutputPipeline *output) const {
+  std::vector<char> accepted(inputs.size(), false);
+  std::atomic<std::size_t> next{0};
+  std::exception_ptr error;
+  std::mutex errorMutex;
+
+  auto work = [&](){
+    try{
+      for(std::size_t n = next++; n < inputs.size(); n = next++){
+        Trace::Span span{"input", "parse", static_cast<std::int64_t>(n)};
+        // Without output no Table is needed, only the result
+        if(!output){
+          accepted[n] = cache ? cache->recognize(grammar, inputs[n])
+                              : grammar.recognize(inputs[n]);
+          continue;
+        }
+        // Sinks that only need a chart get the one of the BitsetParser
+        if(output->usesChart()){
+          const BitsetParser& parser = grammar.getBitsetParser();
+          Chart chart = parser.fill(inputs[n]);
+          accepted[n] = parser.accepts(chart);
+          output->submit(inputs[n], std::move(chart), accepted[n]);
+          continue;
+        }
+        Table table = grammar.fillTable(inputs[n]);
+        accepted[n] = grammar.accepts(table);
+        // The pipeline accounts for the table once it is submitted
+        output->submit(inputs[n], std::move(table), accepted[n]);
+      }
+    }catch(...){
+      std::lock_guard<std::mutex> lock(errorMutex);
+      if(!error){ error = std::current_exception(); }
+      next = inputs.size(); // Let the other threads stop as well
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for(unsigned int t = 1; t < threads; ++t){
+    workers.emplace_back([&work, t](){
+      Trace::nameThread("parser " + std::to_string(t));
+      work();
+    });
+  }
+  Trace::nameThread("parser 0");
+  work();
+  for(auto& worker: workers){ worker.join(); }
+  if(error){ std::rethrow_exception(error); }
+  return accepted;
+}
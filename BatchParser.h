@@ -0,0 +1,61 @@
+//============================================================================
+// Name        : BatchParser.h
+// Author      : Tobias Wilfert
+//============================================================================
+
+#ifndef CYK__BATCHPARSER_H_
+#define CYK__BATCHPARSER_H_
+
+#include <string>
+#include <vector>
+
+#include "ResultCache.h"
+#include "OutputPipeline.h"
+#include "ContextFreeGrammar.h"
+
+namespace CYK{
+
+/**
+ * Runs the CYK on many inputs at once on a fixed number of parser threads
+ *
+ * The threads take the next input that has not been parsed yet, so long and
+ * short inputs are balanced over the threads. The filled in tables are handed
+ * to an OutputPipeline, the parser threads never wait for the output to be
+ * written unless the queue of the pipeline is full.
+ */
+class BatchParser {
+ private:
+  /// The CFG the inputs are checked against
+  const ContextFreeGrammar& grammar;
+
+  /// The number of parser threads
+  unsigned int threads;
+
+  /// Remembers the results of earlier inputs, may be nullptr
+  ResultCache* cache;
+
+ public:
+  /**
+   * Creates a batch parser
+   * @param grammar The CFG, needs to outlive the parser
+   * @param threads The number of parser threads (at least 1)
+   * @param cache Remembers the results of earlier inputs, only used when no
+   *    tables are needed, may be nullptr
+   */
+  BatchParser(const ContextFreeGrammar& grammar, unsigned int threads,
+              ResultCache* cache = nullptr);
+
+  /**
+   * Checks which inputs are in the language of the CFG
+   * @param inputs The input strings
+   * @param output Receives the filled in tables (in no particular order),
+   *    nullptr if only the result matters
+   * @return For every input whether it is in the language of the CFG
+   */
+  std::vector<char> recognize(const std::vector<std::string>& inputs,
+                              OutputPipeline* output = nullptr) const;
+};
+
+} // namespace CYK
+
+#endif//CYK__BATCHPARSER_H_
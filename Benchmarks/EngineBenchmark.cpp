@@ -0,0 +1,425 @@
+//============================================================================
+// Name        : EngineBenchmark.cpp
+// Author      : Tobias Wilfert
+//============================================================================
+
+// Microbenchmarks of the parts of the CYK, every result is printed as one
+// line of JSON so runs can be stored and compared over time.
+//
+// Usage: cyk_bench [--grammar=<path>]... [--variables=<n>,...]
+//                  [--lengths=<n>,...] [--min-time=<seconds>]
+//                  [--filter=<text>]
+//
+// The baseline cases are Grammar.json with the strings of test.sh. They are
+// followed by every grammar (Grammar.json, the --grammar files and synthetic
+// grammars from GrammarGenerator with --variables variables) with strings of
+// every --lengths length, sampled from the language of the grammar where it
+// has strings of that length. The benchmarks are:
+//   table       ContextFreeGrammar::generateCYKTable
+//   first_row   filling in the cells of the single characters
+//   splits      filling in the other cells, the span/split loop
+//   rule_lookup Productions::getVariablesThatProduce for every pair of
+//               variables, the time is per lookup
+//   html        HTMLWriter writing the filled in table (to no file)
+//   fill        ContextFreeGrammar::fillTable diagonal by diagonal, all of
+//               the above but the html
+//   fill_tiled  ContextFreeGrammar::fillTable in tiles, with the tile size
+//               ContextFreeGrammar::tune picks on the start of the input the
+//               way the CYK executable does (printed as "tile")
+//   bitset      BitsetParser::fill, with every BitKernels kernel the CPU
+//               supports (printed as "kernel")
+//
+// The bitset benchmarks are the fastest ones for long strings, use
+// --filter=bitset to not build a Table for them at all, or --filter=fill to
+// compare the orders of the Table.
+//
+// --verify runs no benchmarks, it checks that BitsetParser::fill gives the
+// chart of ContextFreeGrammar::fillTable with every kernel for the same
+// grammars and strings (and the strings reversed), and fails if one differs.
+// A Table is too slow for long strings, so the strings of every grammar
+// include one of verifyLength characters, for which the kernels are
+// compared with the scalar one. Shorter strings only use the partial words
+// at the ends of a row. The Table filled in small tiles is compared with the
+// one filled diagonal by diagonal as well.
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+#include <streambuf>
+
+#include "../HTMLWriter.h"
+#include "../BitKernels.h"
+#include "../BitsetParser.h"
+#include "../GrammarGenerator.h"
+#include "../ContextFreeGrammar.h"
+
+#ifndef CYK_BASELINE_GRAMMAR
+#define CYK_BASELINE_GRAMMAR "Grammar.json"
+#endif
+
+namespace {
+
+/// The strings of test.sh
+const char* const baselineInputs[] = {"abbc", "cbcbcbccbc", "cbccbc",
+                                      "bcbbcbbbccbcbccb"};
+
+/// The longest strings --verify compares with a Table
+constexpr std::size_t verifyTableLength = 64;
+
+/// The length of the string --verify adds, long enough for the vector kernels
+constexpr std::size_t verifyLength = 700;
+
+/// The tile sizes --verify fills the Table with, small enough for several
+/// tiles per string
+const std::size_t verifyTiles[] = {1, 3, 8};
+
+/// The longest start of the input fill_tiled tunes the tile size on
+constexpr std::size_t tuneLength = 512;
+
+/// The benchmarks that need a Table of the input
+const char* const tableBenchmarks[] = {"table", "first_row", "splits",
+                                       "rule_lookup", "html", "fill",
+                                       "fill_tiled"};
+
+/// A grammar that is benchmarked
+struct Case {
+  std::string name;
+  CYK::ContextFreeGrammar grammar;
+};
+
+/// The settings of the run
+struct Settings {
+  std::vector<std::string> grammars;
+  std::vector<std::size_t> variables{16, 32};
+  std::vector<std::size_t> lengths{8, 16, 32};
+  double minTime = 0.2;
+  std::string filter;
+  bool verify = false;
+};
+
+/// Discards everything written to it
+class NullBuffer : public std::streambuf {
+ protected:
+  int overflow(int c) override { return c; }
+  std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+/// Keeps the compiler from removing the benchmarked work
+volatile std::size_t sink;
+
+/// @return The numbers in a comma separated list
+std::vector<std::size_t> parseList(const std::string& list) {
+  std::vector<std::size_t> numbers;
+  std::stringstream stream(list);
+  for(std::string number; std::getline(stream, number, ',');){
+    if(!number.empty()){ numbers.push_back(std::stoul(number)); }
+  }
+  return numbers;
+}
+
+/// @return The grammar in a JSON file
+CYK::ContextFreeGrammar load(const std::string& path) {
+  std::ifstream in(path);
+  if(!in){ throw std::runtime_error("Could not open " + path); }
+  json j;
+  in >> j;
+  return CYK::ContextFreeGrammar{j};
+}
+
+/**
+ * Creates a random CNF grammar over {a, b, c}, always the same for a size
+ * @param variables The number of variables
+ * @return The grammar, with 3 binary productions per variable
+ */
+CYK::ContextFreeGrammar synthetic(std::size_t variables) {
+  CYK::GrammarShape shape;
+  shape.variables = variables;
+  shape.terminals = 3;
+  shape.rules = 3 * variables;
+  shape.ambiguity = 0.1;
+  return CYK::ContextFreeGrammar{CYK::GrammarGenerator{42}.grammar(shape)};
+}
+
+/**
+ * Get an input of a certain length, a string in the language of the grammar
+ * if it has one of that length and else the longest test.sh string repeated
+ * @param grammar The grammar
+ * @param length The length of the string
+ * @return The string
+ */
+std::string inputOfLength(const CYK::ContextFreeGrammar& grammar,
+                          std::size_t length) {
+  try{
+    return CYK::GrammarGenerator{length}.accepted(grammar, length, 1).front();
+  }catch(const std::invalid_argument&){}
+  const std::string pattern = baselineInputs[3];
+  std::string input;
+  for(std::size_t c = 0; c < length; ++c){
+    input.push_back(pattern[c % pattern.size()]);
+  }
+  return input;
+}
+
+/// @return Whether a benchmark is selected by --filter
+bool selected(const Settings& settings, const std::string& name,
+              const std::string& grammar) {
+  return settings.filter.empty() ||
+         (name + "/" + grammar).find(settings.filter) != std::string::npos;
+}
+
+/**
+ * Runs a benchmark for at least minTime seconds and prints the result
+ * @param settings The settings of the run
+ * @param name The name of the benchmark
+ * @param grammar The name of the grammar
+ * @param variables The number of variables of the grammar
+ * @param input The input string
+ * @param operations The number of operations one call of body does
+ * @param body The work that is measured
+ * @param extra More fields of the result
+ */
+template<typename Body>
+void run(const Settings& settings, const std::string& name,
+         const std::string& grammar, std::size_t variables,
+         const std::string& input, std::size_t operations, Body body,
+         const json& extra = json::object()) {
+  if(!selected(settings, name, grammar)){ return; }
+  using Clock = std::chrono::steady_clock;
+  body(); // Warm up
+
+  // Measure batches of calls until minTime has passed, keep the best batch
+  std::size_t batch = 1;
+  std::size_t iterations = 0;
+  double total = 0;
+  double best = -1;
+  while(total < settings.minTime){
+    auto start = Clock::now();
+    for(std::size_t b = 0; b < batch; ++b){ body(); }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    total += seconds;
+    iterations += batch;
+    double perCall = seconds / batch;
+    if(best < 0 || perCall < best){ best = perCall; }
+    if(seconds < settings.minTime / 20){ batch *= 2; }
+  }
+
+  json result = extra;
+  result["benchmark"] = name;
+  result["grammar"] = grammar;
+  result["variables"] = variables;
+  result["length"] = input.size();
+  result["input"] = input.size() <= 32 ? input : input.substr(0, 29) + "...";
+  result["iterations"] = iterations;
+  result["ns_per_op"] = total / iterations / operations * 1e9;
+  result["best_ns_per_op"] = best / operations * 1e9;
+  std::cout << result.dump() << std::endl;
+}
+
+/// Runs all benchmarks for a grammar and an input
+void benchmark(const Settings& settings, const Case& test,
+               const std::string& input) {
+  const CYK::ContextFreeGrammar& grammar = test.grammar;
+  const std::vector<std::string> variables = grammar.getVariables();
+  const std::size_t size = input.size();
+  const std::size_t count = variables.size();
+
+  CYK::BitsetParser parser{grammar};
+  CYK::ParserContext& context = CYK::ParserContext::local();
+  const CYK::BitKernel best = CYK::BitKernels::best();
+  for(CYK::BitKernel kernel: {CYK::BitKernel::Scalar, CYK::BitKernel::AVX2,
+                              CYK::BitKernel::AVX512}){
+    if(!CYK::BitKernels::isSupported(kernel)){ continue; }
+    CYK::BitKernels::set(kernel);
+    run(settings, "bitset", test.name, count, input, 1, [&](){
+      sink = parser.fill(input, context).getSize();
+    }, {{"kernel", CYK::BitKernels::name(kernel)}});
+  }
+  CYK::BitKernels::set(best);
+
+  if(std::none_of(std::begin(tableBenchmarks), std::end(tableBenchmarks),
+                  [&](const char* name){
+                    return selected(settings, name, test.name);
+                  })){
+    return;
+  }
+
+  run(settings, "table", test.name, count, input, 1, [&](){
+    sink = CYK::ContextFreeGrammar::generateCYKTable(size).size();
+  });
+
+  CYK::Table table = CYK::ContextFreeGrammar::generateCYKTable(size);
+  run(settings, "first_row", test.name, count, input, 1, [&](){
+    for(std::size_t j = 0; j < size; ++j){
+      table[0][j] = grammar.fillCell(table, input, 0, j);
+    }
+    sink = table[0].size();
+  });
+
+  // The rows only depend on the rows below, so they can be filled again
+  run(settings, "splits", test.name, count, input, 1, [&](){
+    for(std::size_t i = 1; i < size; ++i){
+      for(std::size_t j = 0; j < size - i; ++j){
+        table[i][j] = grammar.fillCell(table, input, i, j);
+      }
+    }
+    sink = table.back()[0].size();
+  });
+
+  run(settings, "rule_lookup", test.name, count, input, count * count, [&](){
+    std::size_t found = 0;
+    for(auto& left: variables){
+      for(auto& right: variables){
+        found += grammar.getProductions().getVariablesThatProduce(
+            {left, right}).size();
+      }
+    }
+    sink = found;
+  });
+
+  NullBuffer buffer;
+  std::ostream nowhere(&buffer);
+  run(settings, "html", test.name, count, input, 1, [&](){
+    CYK::HTMLWriter{nowhere}.write(input, table);
+  });
+
+  CYK::ContextFreeGrammar diagonal = grammar;
+  diagonal.setTile(0);
+  run(settings, "fill", test.name, count, input, 1, [&](){
+    sink = diagonal.fillTable(input).size();
+  });
+
+  if(selected(settings, "fill_tiled", test.name)){
+    CYK::ContextFreeGrammar tiled = grammar;
+    const std::size_t tile = tiled.tune(input.substr(0, tuneLength));
+    run(settings, "fill_tiled", test.name, count, input, 1, [&](){
+      sink = tiled.fillTable(input).size();
+    }, {{"tile", tile}});
+  }
+}
+
+/**
+ * Checks that the BitsetParser fills in the chart of the Table with every
+ * kernel the CPU supports, and that the Table filled in tiles is the one
+ * filled by diagonal, and prints every result
+ * @param test The grammar
+ * @param input The input string, longer ones are compared with the scalar
+ *    kernel instead of a Table
+ * @return Whether the charts of all kernels and the tiled tables were equal
+ *    to the reference
+ */
+bool verify(const Case& test, const std::string& input) {
+  CYK::BitsetParser parser{test.grammar};
+  const bool table = input.size() <= verifyTableLength;
+  const CYK::BitKernel best = CYK::BitKernels::best();
+  CYK::BitKernels::set(CYK::BitKernel::Scalar);
+  const CYK::Chart expected =
+      table ? CYK::Chart{test.grammar.fillTable(input),
+                         test.grammar.getVariables()}
+            : parser.fill(input);
+  bool equal = true;
+  for(CYK::BitKernel kernel: {CYK::BitKernel::Scalar, CYK::BitKernel::AVX2,
+                              CYK::BitKernel::AVX512}){
+    if(!CYK::BitKernels::isSupported(kernel)){ continue; }
+    CYK::BitKernels::set(kernel);
+    const bool same = parser.fill(input).getCells() == expected.getCells();
+    json result;
+    result["verify"] = "bitset";
+    result["grammar"] = test.name;
+    result["length"] = input.size();
+    result["input"] = input.size() <= 32 ? input : input.substr(0, 29) + "...";
+    result["kernel"] = CYK::BitKernels::name(kernel);
+    result["reference"] = table ? "table" : "scalar";
+    result["equal"] = same;
+    std::cout << result.dump() << std::endl;
+    equal = equal && same;
+  }
+  CYK::BitKernels::set(best);
+  if(!table){ return equal; }
+
+  CYK::ContextFreeGrammar tiled = test.grammar;
+  tiled.setTile(0);
+  const CYK::Table diagonal = tiled.fillTable(input);
+  for(std::size_t tile: verifyTiles){
+    tiled.setTile(tile);
+    const bool same = tiled.fillTable(input) == diagonal;
+    json result;
+    result["verify"] = "table_tiled";
+    result["grammar"] = test.name;
+    result["length"] = input.size();
+    result["input"] = input.size() <= 32 ? input : input.substr(0, 29) + "...";
+    result["tile"] = tile;
+    result["reference"] = "diagonal";
+    result["equal"] = same;
+    std::cout << result.dump() << std::endl;
+    equal = equal && same;
+  }
+  return equal;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  Settings settings;
+  for(int i = 1; i < argc; ++i){
+    std::string arg = argv[i];
+    if(arg.rfind("--grammar=", 0) == 0){
+      settings.grammars.push_back(arg.substr(10));
+    }else if(arg.rfind("--variables=", 0) == 0){
+      settings.variables = parseList(arg.substr(12));
+    }else if(arg.rfind("--lengths=", 0) == 0){
+      settings.lengths = parseList(arg.substr(10));
+    }else if(arg.rfind("--min-time=", 0) == 0){
+      settings.minTime = std::stod(arg.substr(11));
+    }else if(arg.rfind("--filter=", 0) == 0){
+      settings.filter = arg.substr(9);
+    }else if(arg == "--verify"){
+      settings.verify = true;
+    }else{
+      std::cerr << "Unknown argument " << arg << std::endl;
+      return 1;
+    }
+  }
+
+  try{
+    std::vector<Case> cases{{"Grammar.json", load(CYK_BASELINE_GRAMMAR)}};
+    bool equal = true;
+    auto check = [&](const Case& test, std::string input){
+      if(!settings.verify){
+        benchmark(settings, test, input);
+        return;
+      }
+      equal = verify(test, input) && equal;
+      std::reverse(input.begin(), input.end());
+      equal = verify(test, input) && equal;
+    };
+    for(auto& input: baselineInputs){ check(cases[0], input); }
+
+    for(auto& path: settings.grammars){ cases.push_back({path, load(path)}); }
+    for(auto variables: settings.variables){
+      cases.push_back({"synthetic-" + std::to_string(variables),
+                       synthetic(variables)});
+    }
+    for(auto& test: cases){
+      for(auto length: settings.lengths){
+        check(test, inputOfLength(test.grammar, length));
+      }
+      if(settings.verify){
+        check(test, inputOfLength(test.grammar, verifyLength));
+      }
+    }
+    if(!equal){
+      std::cerr << "The BitsetParser, fillTable and its tiles disagree"
+                << std::endl;
+      return 1;
+    }
+  }catch(const std::exception& e){
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,130 @@
+//============================================================================
+// Name        : HTMLBenchmark.cpp
+// Author      : Tobias Wilfert
+//============================================================================
+
+// Measures the time and peak memory of generating the HTML representation of
+// a large table. The table is synthetic (every cell gets a pseudo random
+// subset of four variables) so that sizes far beyond what the CYK can fill in
+// reasonable time can be measured.
+//
+// Usage: cyk_html_bench <size> [legacy]
+// With "legacy" the document is built in a single std::string first, the way
+// createHTMLRepresentation used to do it.
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <fstream>
+#include <iostream>
+
+#ifdef __unix__
+#include <sys/resource.h>
+#endif
+
+#include "../HTMLWriter.h"
+
+namespace {
+
+/// @return The peak resident set size of the process in KiB, 0 if unknown
+long peakRSS() {
+#ifdef __unix__
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+#else
+  return 0;
+#endif
+}
+
+/// Builds a table of size x size with a pseudo random subset of 4 variables
+CYK::Table syntheticTable(std::size_t size, std::string &input) {
+  const std::string variables[] = {"A", "B", "C", "S"};
+  unsigned int state = 42;
+  CYK::Table table;
+  for(std::size_t i = 0; i < size; ++i){
+    input.push_back("abc"[i % 3]);
+    table.emplace_back(size - i);
+    for(auto& cell: table.back()){
+      state = state * 1103515245 + 12345;
+      for(int v = 0; v < 4; ++v){
+        if((state >> (16 + v)) & 1){ cell.insert(variables[v]); }
+      }
+    }
+  }
+  return table;
+}
+
+/// The original implementation, building the whole document in memory
+void legacyHTML(std::ostream &out, const std::string &input,
+                const CYK::Table &table) {
+  std::string htmlDoc = "<html lang=\"en\" >\n"
+                        "<style>\n"
+                        "  table, td { border: 1px solid black;\n"
+                        "              padding: 5px;}\n"
+                        "  html *{font-family: Arial, Helvetica, sans-serif;}\n"
+                        "</style>\n"
+                        "<table>\n";
+  htmlDoc += ("<caption>CYK table for \"" + input + "\"</caption>\n");
+  for(int i = table.size()-1; i > -1; --i){
+    htmlDoc += "  <tr>\n";
+    for(auto& col: table.at(i)){
+      htmlDoc += "    <td>";
+      for(auto& con: col){
+        htmlDoc += con + ",";
+      }
+      if(htmlDoc.back() == ','){ htmlDoc.pop_back(); }
+      htmlDoc += "</td>\n";
+    }
+    htmlDoc += "  </tr>\n";
+  }
+  htmlDoc += "  <tr>\n";
+  for(auto& s: input){
+    htmlDoc += ("    <th>" + std::string{s} + "</th>\n");
+  }
+  htmlDoc += "  </tr>\n"
+             "</table>\n"
+             "</html>";
+  out << htmlDoc;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  if(argc < 2){
+    std::cerr << "Usage: " << argv[0] << " <size> [legacy]" << std::endl;
+    return 1;
+  }
+  const std::size_t size = std::stoul(argv[1]);
+  const bool legacy = argc > 2 && std::string{argv[2]} == "legacy";
+
+  std::string input;
+  CYK::Table table = syntheticTable(size, input);
+  const long tableRSS = peakRSS();
+
+  const char* path = "cyk_html_bench.html";
+  auto start = std::chrono::steady_clock::now();
+  {
+    std::ofstream out(path);
+    if(legacy){
+      legacyHTML(out, input, table);
+    }else{
+      CYK::HTMLWriter{out}.write(input, table);
+    }
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  std::ifstream written(path, std::ios::binary | std::ios::ate);
+  const long long bytes = written.tellg();
+  written.close();
+  std::remove(path);
+
+  std::cout << "{\"writer\": \"" << (legacy ? "legacy" : "streaming") << "\""
+            << ", \"size\": " << size
+            << ", \"bytes\": " << bytes
+            << ", \"seconds\": "
+            << std::chrono::duration<double>(end - start).count()
+            << ", \"table_peak_rss_kib\": " << tableRSS
+            << ", \"peak_rss_kib\": " << peakRSS() << "}" << std::endl;
+  return 0;
+}
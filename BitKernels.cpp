@@ -0,0 +1,153 @@
+//============================================================================
+// Name        : BitKernels.cpp
+// Author      : Tobias Wilfert
+//============================================================================
+
+#include "BitKernels.h"
+
+#include <string>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define CYK_HAS_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+// MSVC compiles the intrinsics of every instruction set without flags
+#define CYK_TARGET(isa)
+#else
+#define CYK_TARGET(isa) __attribute__((target(isa)))
+#endif
+#endif
+
+namespace {
+
+/// Checks whether a & b has a bit set in words full words
+using Kernel = bool (*)(const std::uint64_t*, const std::uint64_t*,
+                        std::size_t);
+
+bool intersectsScalar(const std::uint64_t* a, const std::uint64_t* b,
+                      std::size_t words) {
+  for(std::size_t w = 0; w < words; ++w){
+    if(a[w] & b[w]){ return true; }
+  }
+  return false;
+}
+
+#ifdef CYK_HAS_X86
+CYK_TARGET("avx2")
+bool intersectsAVX2(const std::uint64_t* a, const std::uint64_t* b,
+                    std::size_t words) {
+  std::size_t w = 0;
+  for(; w + 4 <= words; w += 4){
+    const __m256i x =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + w));
+    const __m256i y =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + w));
+    if(!_mm256_testz_si256(x, y)){ return true; }
+  }
+  return intersectsScalar(a + w, b + w, words - w);
+}
+
+CYK_TARGET("avx512f")
+bool intersectsAVX512(const std::uint64_t* a, const std::uint64_t* b,
+                      std::size_t words) {
+  std::size_t w = 0;
+  for(; w + 8 <= words; w += 8){
+    const __m512i x = _mm512_loadu_si512(a + w);
+    const __m512i y = _mm512_loadu_si512(b + w);
+    if(_mm512_test_epi64_mask(x, y)){ return true; }
+  }
+  return intersectsScalar(a + w, b + w, words - w);
+}
+
+/// @return Whether the CPU and the operating system support AVX2 or AVX-512
+bool cpuSupports(CYK::BitKernel kernel) {
+#ifdef _MSC_VER
+  int info[4];
+  __cpuid(info, 1);
+  // The operating system saves the vector registers (OSXSAVE and XCR0)
+  if(!(info[2] & (1 << 27))){ return false; }
+  const unsigned long long xcr0 = _xgetbv(0);
+  __cpuidex(info, 7, 0);
+  if(kernel == CYK::BitKernel::AVX2){
+    return (xcr0 & 0x6) == 0x6 && (info[1] & (1 << 5));
+  }
+  return (xcr0 & 0xe6) == 0xe6 && (info[1] & (1 << 16));
+#else
+  __builtin_cpu_init();
+  if(kernel == CYK::BitKernel::AVX2){ return __builtin_cpu_supports("avx2"); }
+  return __builtin_cpu_supports("avx512f");
+#endif
+}
+#endif
+
+/// @return The implementation of a kernel
+Kernel implementation(CYK::BitKernel kernel) {
+  switch(kernel){
+#ifdef CYK_HAS_X86
+    case CYK::BitKernel::AVX2: return intersectsAVX2;
+    case CYK::BitKernel::AVX512: return intersectsAVX512;
+#endif
+    default: return intersectsScalar;
+  }
+}
+
+/// The kernel that is used and its implementation
+CYK::BitKernel current = CYK::BitKernels::best();
+Kernel currentImplementation = implementation(current);
+
+} // namespace
+
+bool CYK::BitKernels::intersects(const std::uint64_t *a, const std::uint64_t *b,
+                                 std::size_t from, std::size_t to) {
+  if(from >= to){ return false; }
+  const std::size_t first = from / 64;
+  const std::size_t last = (to - 1) / 64;
+  const std::uint64_t head = ~std::uint64_t{0} << (from % 64);
+  const std::uint64_t tail = ~std::uint64_t{0} >> (63 - (to - 1) % 64);
+  if(first == last){ return a[first] & b[first] & head & tail; }
+  // The partial words at the ends, then the full words in between
+  if((a[first] & b[first] & head) || (a[last] & b[last] & tail)){
+    return true;
+  }
+  return currentImplementation(a + first + 1, b + first + 1,
+                               last - first - 1);
+}
+
+CYK::BitKernel CYK::BitKernels::get() {
+  return current;
+}
+
+void CYK::BitKernels::set(CYK::BitKernel kernel) {
+  if(!isSupported(kernel)){
+    throw std::invalid_argument(std::string{"The CPU does not support "} +
+                                name(kernel));
+  }
+  current = kernel;
+  currentImplementation = implementation(kernel);
+}
+
+bool CYK::BitKernels::isSupported(CYK::BitKernel kernel) {
+  if(kernel == BitKernel::Scalar){ return true; }
+#ifdef CYK_HAS_X86
+  return cpuSupports(kernel);
+#else
+  return false;
+#endif
+}
+
+CYK::BitKernel CYK::BitKernels::best() {
+  for(BitKernel kernel: {BitKernel::AVX512, BitKernel::AVX2}){
+    if(isSupported(kernel)){ return kernel; }
+  }
+  return BitKernel::Scalar;
+}
+
+const char *CYK::BitKernels::name(CYK::BitKernel kernel) {
+  switch(kernel){
+    case BitKernel::AVX2: return "avx2";
+    case BitKernel::AVX512: return "avx512";
+    default: return "scalar";
+  }
+}
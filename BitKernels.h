@@ -0,0 +1,68 @@
+//============================================================================
+// Name        : BitKernels.h
+// Author      : Tobias Wilfert
+//============================================================================
+
+#ifndef CYK__BITKERNELS_H_
+#define CYK__BITKERNELS_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace CYK{
+
+/// The implementations of the bit kernels
+enum class BitKernel {
+  Scalar,
+
+  /// 256-bit vectors, x86-64 with AVX2
+  AVX2,
+
+  /// 512-bit vectors, x86-64 with AVX-512F
+  AVX512
+};
+
+/**
+ * The loops over long bitsets that the BitsetParser spends its time in
+ *
+ * Every kernel has a scalar version and, on x86-64, versions that use
+ * 256-bit (AVX2) and 512-bit (AVX-512) vectors. They are all compiled in,
+ * the best one the CPU supports is picked when the program starts, so the
+ * binary runs on any x86-64 CPU.
+ */
+class BitKernels {
+ public:
+  /**
+   * Checks whether two bitsets have a common bit in a range
+   * @param a The words of the first bitset
+   * @param b The words of the second bitset
+   * @param from The first bit of the range
+   * @param to The bit after the range, both bitsets need to have it
+   * @return Whether a & b has a bit in [from, to)
+   */
+  static bool intersects(const std::uint64_t* a, const std::uint64_t* b,
+                         std::size_t from, std::size_t to);
+
+  /// @return The kernel that is used
+  static BitKernel get();
+
+  /**
+   * Changes the kernel that is used, not while a BitsetParser is filling
+   * @param kernel A kernel the CPU supports
+   * @throw std::invalid_argument If the CPU does not support the kernel
+   */
+  static void set(BitKernel kernel);
+
+  /// @return Whether the CPU (and the compiler) support a kernel
+  static bool isSupported(BitKernel kernel);
+
+  /// @return The fastest kernel the CPU supports
+  static BitKernel best();
+
+  /// @return The name of a kernel: scalar, avx2 or avx512
+  static const char* name(BitKernel kernel);
+};
+
+} // namespace CYK
+
+#endif//CYK__BITKERNELS_H_
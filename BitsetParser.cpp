@@ -0,0 +1,200 @@
+//============================================================================
+// Name        : BitsetParser.cpp
+// Author      : Tobias Wilfert
+//============================================================================
+
+#include "BitsetParser.h"
+
+#include <map>
+
+#include "Trace.h"
+#include "BitKernels.h"
+#include "PerfCounters.h"
+#include "Instrumentation.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace {
+
+/// @return The index of the lowest bit set in word, which may not be 0
+std::size_t lowestBit(std::uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_ctzll(word);
+#elif defined(_MSC_VER) && defined(_M_X64)
+  unsigned long index;
+  _BitScanForward64(&index, word);
+  return index;
+#else
+  std::size_t index = 0;
+  for(; !(word & 1); word >>= 1){ ++index; }
+  return index;
+#endif
+}
+
+} // namespace
+
+CYK::BitsetParser::BitsetParser(const CYK::ContextFreeGrammar &grammar)
+    : symbols(grammar.getVariables()) {
+  std::map<std::string, std::size_t> index;
+  for(std::size_t v = 0; v < symbols.size(); ++v){ index[symbols[v]] = v; }
+  words = (symbols.size() + 63) / 64;
+  auto it = index.find(grammar.getStartSymbol());
+  start = it == index.end() ? symbols.size() : it->second;
+  terminals.assign(256 * words, 0);
+  lefts.assign(words, 0);
+  pairs.resize(symbols.size());
+
+  // The heads of every pair, in the same order as the pairs will be
+  std::map<std::pair<std::size_t, std::size_t>, std::vector<std::size_t>> byPair;
+  for(auto& production: grammar.getProductions().getProductions()){
+    const std::size_t head = index.at(production.first);
+    for(auto& body: production.second){
+      if(body.size() == 1 && body[0].size() == 1){
+        const auto c = static_cast<unsigned char>(body[0][0]);
+        terminals[c * words + head / 64] |= std::uint64_t{1} << (head % 64);
+      }else if(body.size() == 2 && index.count(body[0]) &&
+               index.count(body[1])){
+        byPair[{index[body[0]], index[body[1]]}].push_back(head);
+      }
+    }
+  }
+  leftRows.assign(symbols.size(), symbols.size());
+  rightRows.assign(symbols.size(), symbols.size());
+  for(auto& pair: byPair){
+    const std::size_t left = pair.first.first;
+    const std::size_t right = pair.first.second;
+    if(leftRows[left] == symbols.size()){ leftRows[left] = leftCount++; }
+    if(rightRows[right] == symbols.size()){ rightRows[right] = rightCount++; }
+    lefts[left / 64] |= std::uint64_t{1} << (left % 64);
+    pairs[left].push_back({pair.first.second, heads.size()});
+    heads.resize(heads.size() + words, 0);
+    for(std::size_t head: pair.second){
+      heads[pairs[left].back().heads + head / 64] |=
+          std::uint64_t{1} << (head % 64);
+    }
+  }
+}
+
+std::size_t CYK::BitsetParser::rowWords(std::size_t length) {
+  return (length + 63) / 64;
+}
+
+std::uint64_t *CYK::BitsetParser::leftRow(const CYK::BitsetParser::Rows &rows,
+                                          std::size_t B, std::size_t b) const {
+  return rows.bits + (leftRows[B] * rows.size + b) * rows.words;
+}
+
+std::uint64_t *CYK::BitsetParser::rightRow(const CYK::BitsetParser::Rows &rows,
+                                           std::size_t C, std::size_t e) const {
+  return rows.bits + ((leftCount + rightRows[C]) * rows.size + e) * rows.words;
+}
+
+void CYK::BitsetParser::publish(const CYK::Chart &chart,
+                                const CYK::BitsetParser::Rows &rows,
+                                std::size_t i, std::size_t j) const {
+  const std::uint64_t* cell = chart.cell(i, j);
+  const std::size_t e = j + i;
+  for(std::size_t w = 0; w < words; ++w){
+    for(std::uint64_t bits = cell[w]; bits; bits &= bits - 1){
+      const std::size_t variable = w * 64 + lowestBit(bits);
+      if(leftRows[variable] != symbols.size()){
+        leftRow(rows, variable, j)[e / 64] |= std::uint64_t{1} << (e % 64);
+      }
+      // The cell is the right side of split point j-1
+      if(j > 0 && rightRows[variable] != symbols.size()){
+        rightRow(rows, variable, e)[(j - 1) / 64] |=
+            std::uint64_t{1} << ((j - 1) % 64);
+      }
+    }
+  }
+}
+
+void CYK::BitsetParser::fillCell(CYK::Chart &chart,
+                                 const CYK::BitsetParser::Rows &rows,
+                                 std::size_t i, std::size_t j) const {
+  std::uint64_t* cell = chart.cell(i, j);
+  // Split k combines (j,j+k) and (j+k+1,j+i), which is split point j+k
+  for(std::size_t w = 0; w < words; ++w){
+    for(std::uint64_t bits = lefts[w]; bits; bits &= bits - 1){
+      const std::size_t left = w * 64 + lowestBit(bits);
+      const std::uint64_t* ends = leftRow(rows, left, j);
+      for(const Pair& pair: pairs[left]){
+        const std::uint64_t* produced = heads.data() + pair.heads;
+        // Pairs that can only add variables the cell has are skipped
+        bool adds = false;
+        for(std::size_t h = 0; h < words && !adds; ++h){
+          adds = produced[h] & ~cell[h];
+        }
+        if(!adds || !BitKernels::intersects(
+            ends, rightRow(rows, pair.right, j + i), j, j + i)){
+          continue;
+        }
+        for(std::size_t h = 0; h < words; ++h){ cell[h] |= produced[h]; }
+      }
+    }
+  }
+  publish(chart, rows, i, j);
+}
+
+CYK::Chart CYK::BitsetParser::fill(const std::string &input) const {
+  Chart chart{symbols, input.size()};
+  fill(chart, input, ParserContext::local());
+  return chart;
+}
+
+const CYK::Chart &CYK::BitsetParser::fill(const std::string &input,
+                                          CYK::ParserContext &context) const {
+  Chart& chart = context.getChart(symbols, input.size());
+  fill(chart, input, context);
+  return chart;
+}
+
+void CYK::BitsetParser::fill(CYK::Chart &chart, const std::string &input,
+                             CYK::ParserContext &context) const {
+  const std::size_t size = input.size();
+  CYK_PROFILE_START(size);
+  Rows rows{nullptr, size, rowWords(size)};
+  rows.bits = context.getBits((leftCount + rightCount) * size * rows.words);
+  {
+    CYK_PROFILE_TIME(diagonals[0]);
+    Trace::Span span{"diagonal", "bitset", 0};
+    CYK_PERF_PHASE(PerfPhase::FirstRow);
+    for(std::size_t j = 0; j < size; ++j){
+      const std::uint64_t* produced =
+          terminals.data() + static_cast<unsigned char>(input[j]) * words;
+      std::uint64_t* cell = chart.cell(0, j);
+      for(std::size_t w = 0; w < words; ++w){ cell[w] = produced[w]; }
+      publish(chart, rows, 0, j);
+    }
+  }
+  for(std::size_t i = 1; i < size; ++i){
+    CYK_PROFILE_TIME(diagonals[i]);
+    Trace::Span span{"diagonal", "bitset", static_cast<std::int64_t>(i)};
+    CYK_PERF_PHASE(PerfPhase::Splits);
+    for(std::size_t j = 0; j < size - i; ++j){ fillCell(chart, rows, i, j); }
+  }
+}
+
+bool CYK::BitsetParser::accepts(const CYK::Chart &chart) const {
+  return chart.getSize() > 0 && start < symbols.size() &&
+         chart.test(chart.getSize() - 1, 0, start);
+}
+
+const std::vector<std::string> &CYK::BitsetParser::getSymbols() const {
+  return symbols;
+}
+
+std::size_t CYK::BitsetParser::getRowBytes(std::size_t length) const {
+  return (leftCount + rightCount) * length * rowWords(length) *
+         sizeof(std::uint64_t);
+}
+
+std::size_t CYK::BitsetParser::getBytes() const {
+  std::size_t bytes = sizeof(*this) +
+      (terminals.capacity() + lefts.capacity() + heads.capacity()) *
+      sizeof(std::uint64_t) + pairs.capacity() * sizeof(pairs[0]);
+  for(auto& left: pairs){ bytes += left.capacity() * sizeof(Pair); }
+  return bytes;
+}
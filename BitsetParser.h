@@ -0,0 +1,159 @@
+//============================================================================
+// Name        : BitsetParser.h
+// Author      : Tobias Wilfert
+//============================================================================
+
+#ifndef CYK__BITSETPARSER_H_
+#define CYK__BITSETPARSER_H_
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "Chart.h"
+#include "ParserContext.h"
+#include "ContextFreeGrammar.h"
+
+namespace CYK{
+
+/**
+ * A lean CYK that fills in a Chart directly, without ever building a Table
+ *
+ * Every cell is a bitset over the variables, so a table of n characters takes
+ * n(n+1)/2 * ceil(variables/64) words instead of a std::set of strings per
+ * cell. The productions are turned into bitsets once: for every variable B
+ * the variables C with a production A -> B C, each with the bitset of those
+ * heads A. It recognizes the same strings and fills in the same cells as
+ * ContextFreeGrammar::fillTable.
+ *
+ * While filling, the cells are also kept by variable as rows of bits: for a
+ * left variable B and a start b the ends m of the cells (b,m) that contain
+ * B, for a right variable C and an end e the split points m of the cells
+ * (m+1,e) that contain C. A pair (B, C) adds its heads to cell (b,e) if the
+ * row of B at b and the row of C at e have a split point in common, which
+ * BitKernels::intersects checks 256 or 512 split points at a time, instead
+ * of checking every pair at every split.
+ */
+class BitsetParser {
+ private:
+  /// The binary productions with a left variable B and right variable C
+  struct Pair {
+    /// The index of C
+    std::size_t right;
+
+    /// The position of the bitset of the heads in heads
+    std::size_t heads;
+  };
+
+  /// The variables of the CFG, see ContextFreeGrammar::getVariables
+  std::vector<std::string> symbols;
+
+  /// The number of 64-bit words per cell
+  std::size_t words;
+
+  /// The index of the start symbol, symbols.size() if it is not a variable
+  std::size_t start;
+
+  /// The bitset of the variables producing every character, 256 * words
+  std::vector<std::uint64_t> terminals;
+
+  /// The bitset of the variables that are the left side of a production
+  std::vector<std::uint64_t> lefts;
+
+  /// The pairs of every left variable B
+  std::vector<std::vector<Pair>> pairs;
+
+  /// The bitsets of the heads of all pairs
+  std::vector<std::uint64_t> heads;
+
+  /// The row of every variable that is a left or right variable of a pair,
+  /// symbols.size() if it is not
+  std::vector<std::size_t> leftRows;
+  std::vector<std::size_t> rightRows;
+
+  /// The number of left and right variables
+  std::size_t leftCount = 0;
+  std::size_t rightCount = 0;
+
+  /// The rows of the variables of a chart that is being filled
+  struct Rows {
+    /// The left rows of every start, then the right rows of every end
+    std::uint64_t* bits;
+
+    /// The length of the input
+    std::size_t size;
+
+    /// The number of words per row
+    std::size_t words;
+  };
+
+  /// @return The number of words per row for an input of a length
+  static std::size_t rowWords(std::size_t length);
+
+  /// @return The row of left variable B for start b
+  std::uint64_t* leftRow(const Rows& rows, std::size_t B, std::size_t b) const;
+
+  /// @return The row of right variable C for end e
+  std::uint64_t* rightRow(const Rows& rows, std::size_t C, std::size_t e) const;
+
+  /// Adds the variables of cell (i,j) to the rows
+  void publish(const Chart& chart, const Rows& rows, std::size_t i,
+               std::size_t j) const;
+
+  /**
+   * Computes the variables of a single cell
+   * @param chart The chart, the cells of the rows below row i need to be filled
+   * @param rows The rows of the chart
+   * @param i The row of the cell (the length of the substring minus one)
+   * @param j The column of the cell (the start of the substring)
+   */
+  void fillCell(Chart& chart, const Rows& rows, std::size_t i,
+                std::size_t j) const;
+
+  /// Fills in a chart with empty cells for input, with the rows of a context
+  void fill(Chart& chart, const std::string& input,
+            ParserContext& context) const;
+
+ public:
+  /**
+   * Converts the productions of a CFG into bitsets
+   * @param grammar The CFG, it is not needed after the constructor
+   */
+  explicit BitsetParser(const ContextFreeGrammar& grammar);
+
+  /**
+   * Fills in the chart for input
+   * @param input The input string the chart is for
+   * @return The filled in chart with getSymbols() as its variables
+   */
+  Chart fill(const std::string& input) const;
+
+  /**
+   * Fills in the reused chart of a context for input
+   * @param input The input string the chart is for
+   * @param context The context whose chart is filled in
+   * @return The filled in chart, valid until the context is used again
+   */
+  const Chart& fill(const std::string& input, ParserContext& context) const;
+
+  /**
+   * Checks whether a chart accepts its input
+   * @param chart A chart filled in by fill
+   * @return Whether the start symbol produces the whole input
+   */
+  bool accepts(const Chart& chart) const;
+
+  /// @return The variables of the charts
+  const std::vector<std::string>& getSymbols() const;
+
+  /// @return The number of bytes the bitsets of the productions use
+  std::size_t getBytes() const;
+
+  /// @return The number of bytes of the rows of an input of a length
+  std::size_t getRowBytes(std::size_t length) const;
+
+};
+
+} // namespace CYK
+
+#endif//CYK__BITSETPARSER_H_
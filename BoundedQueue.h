@@ -0,0 +1,138 @@
+//============================================================================
+// Name        : BoundedQueue.h
+// Author      : Tobias Wilfert
+//============================================================================
+
+#ifndef CYK__BOUNDEDQUEUE_H_
+#define CYK__BOUNDEDQUEUE_H_
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <utility>
+
+namespace CYK{
+
+/**
+ * A bounded lock-free queue for multiple producers and multiple consumers
+ *
+ * Every slot carries a sequence number that tells producers and consumers
+ * whether it is free or full for their current lap around the ring buffer
+ * (D. Vyukov's bounded MPMC queue), so neither side ever takes a lock.
+ * @tparam T The type of the elements, needs to be default constructible
+ */
+template<typename T>
+class BoundedQueue {
+ private:
+  /// A slot of the ring buffer
+  struct Slot {
+    /// The position the slot is ready for
+    std::atomic<std::size_t> sequence;
+
+    /// The element stored in the slot
+    T value;
+  };
+
+  /// The slots, the number of slots is a power of two
+  std::vector<Slot> slots;
+
+  /// slots.size() - 1
+  std::size_t mask;
+
+  /// The position the next element is pushed to
+  alignas(64) std::atomic<std::size_t> tail{0};
+
+  /// The position the next element is popped from
+  alignas(64) std::atomic<std::size_t> head{0};
+
+  /// @return The smallest power of two that is at least capacity (and 2)
+  static std::size_t roundUp(std::size_t capacity) {
+    std::size_t size = 2;
+    while(size < capacity){ size *= 2; }
+    return size;
+  }
+
+ public:
+  /**
+   * Creates an empty queue
+   * @param capacity The minimum number of elements the queue can hold,
+   *    rounded up to a power of two
+   */
+  explicit BoundedQueue(std::size_t capacity)
+      : slots(roundUp(capacity)), mask(slots.size() - 1) {
+    for(std::size_t i = 0; i < slots.size(); ++i){
+      slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  BoundedQueue(const BoundedQueue&) = delete;
+  BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+  /**
+   * Adds an element if the queue is not full
+   * @param value The element, only moved from if it was added
+   * @return Whether the element was added
+   */
+  bool tryPush(T& value) {
+    std::size_t position = tail.load(std::memory_order_relaxed);
+    for(;;){
+      Slot& slot = slots[position & mask];
+      std::size_t sequence = slot.sequence.load(std::memory_order_acquire);
+      auto difference = static_cast<std::ptrdiff_t>(sequence - position);
+      if(difference == 0){
+        if(tail.compare_exchange_weak(position, position + 1,
+                                      std::memory_order_relaxed)){
+          slot.value = std::move(value);
+          slot.sequence.store(position + 1, std::memory_order_release);
+          return true;
+        }
+      }else if(difference < 0){
+        return false; // The slot still holds an element of the previous lap
+      }else{
+        position = tail.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /**
+   * Removes the oldest element if the queue is not empty
+   * @param value Is set to the element
+   * @return Whether an element was removed
+   */
+  bool tryPop(T& value) {
+    std::size_t position = head.load(std::memory_order_relaxed);
+    for(;;){
+      Slot& slot = slots[position & mask];
+      std::size_t sequence = slot.sequence.load(std::memory_order_acquire);
+      auto difference = static_cast<std::ptrdiff_t>(sequence - (position + 1));
+      if(difference == 0){
+        if(head.compare_exchange_weak(position, position + 1,
+                                      std::memory_order_relaxed)){
+          value = std::move(slot.value);
+          slot.sequence.store(position + mask + 1, std::memory_order_release);
+          return true;
+        }
+      }else if(difference < 0){
+        return false; // The slot has not been filled in this lap yet
+      }else{
+        position = head.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /// @return The number of elements in the queue, approximate while in use
+  std::size_t size() const {
+    std::size_t pushed = tail.load(std::memory_order_relaxed);
+    std::size_t popped = head.load(std::memory_order_relaxed);
+    return pushed >= popped ? pushed - popped : 0;
+  }
+
+  /// @return The number of elements the queue can hold
+  std::size_t capacity() const {
+    return slots.size();
+  }
+};
+
+} // namespace CYK
+
+#endif//CYK__BOUNDEDQUEUE_H_
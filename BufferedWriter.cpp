@@ -0,0 +1,60 @@
+//============================================================================
+// Name        : BufferedWriter.cpp
+// Author      : Tobias Wilfert
+//============================================================================
+
+#include "BufferedWriter.h"
+
+#include <cstring>
+#include <algorithm>
+
+CYK::BufferedWriter::BufferedWriter(std::ostream &out, std::size_t capacity)
+    : out(out), buffer(capacity > 0 ? capacity : 1) {}
+
+CYK::BufferedWriter::~BufferedWriter() {
+  flush();
+}
+
+void CYK::BufferedWriter::write(const char *data, std::size_t length) {
+  while(length > 0){
+    if(used == buffer.size()){ flush(); }
+    std::size_t chunk = std::min(length, buffer.size() - used);
+    std::memcpy(buffer.data() + used, data, chunk);
+    used += chunk;
+    data += chunk;
+    length -= chunk;
+  }
+}
+
+void CYK::BufferedWriter::write(const std::string &text) {
+  write(text.data(), text.size());
+}
+
+void CYK::BufferedWriter::write(const char *text) {
+  write(text, std::strlen(text));
+}
+
+void CYK::BufferedWriter::write(char c) {
+  if(used == buffer.size()){ flush(); }
+  buffer[used++] = c;
+}
+
+void CYK::BufferedWriter::write(unsigned long long number) {
+  char digits[20];
+  std::size_t length = 0;
+  do{
+    digits[sizeof(digits) - ++length] = static_cast<char>('0' + number % 10);
+    number /= 10;
+  }while(number > 0);
+  write(digits + sizeof(digits) - length, length);
+}
+
+void CYK::BufferedWriter::align(std::size_t written) {
+  for(; written % 8 != 0; ++written){ write('\0'); }
+}
+
+void CYK::BufferedWriter::flush() {
+  if(used == 0){ return; }
+  out.write(buffer.data(), used);
+  used = 0;
+}
@@ -0,0 +1,87 @@
+//============================================================================
+// Name        : BufferedWriter.h
+// Author      : Tobias Wilfert
+//============================================================================
+
+#ifndef CYK__BUFFEREDWRITER_H_
+#define CYK__BUFFEREDWRITER_H_
+
+#include <string>
+#include <vector>
+#include <ostream>
+
+namespace CYK{
+
+/**
+ * Writes to an output stream through a fixed-size buffer
+ *
+ * Used to generate large documents without ever holding more than the buffer
+ * in memory, every write is a copy into the buffer and the buffer is handed
+ * to the stream in one call whenever it is full.
+ */
+class BufferedWriter {
+ private:
+  /// The stream that is written to
+  std::ostream& out;
+
+  /// The buffer
+  std::vector<char> buffer;
+
+  /// The number of bytes in the buffer
+  std::size_t used = 0;
+
+ public:
+  /// The size of the buffer if none is given
+  static constexpr std::size_t defaultCapacity = 1 << 16;
+
+  /**
+   * Creates a writer
+   * @param out The stream that should be written to
+   * @param capacity The size of the buffer in bytes
+   */
+  explicit BufferedWriter(std::ostream& out,
+                          std::size_t capacity = defaultCapacity);
+
+  BufferedWriter(const BufferedWriter&) = delete;
+  BufferedWriter& operator=(const BufferedWriter&) = delete;
+
+  /// Flushes the buffer
+  ~BufferedWriter();
+
+  /**
+   * Writes bytes
+   * @param data The first byte
+   * @param length The number of bytes
+   */
+  void write(const char* data, std::size_t length);
+
+  /// Writes a string
+  void write(const std::string& text);
+
+  /// Writes a null terminated string
+  void write(const char* text);
+
+  /// Writes a single character
+  void write(char c);
+
+  /// Writes an unsigned number in decimal
+  void write(unsigned long long number);
+
+  /// Writes an unsigned integer in binary, least significant byte first
+  template<typename T>
+  void writeLittleEndian(T value) {
+    for(std::size_t byte = 0; byte < sizeof(T); ++byte){
+      write(static_cast<char>((value >> (8 * byte)) & 0xff));
+    }
+  }
+
+  /// Writes zero bytes until the number of bytes written is a multiple of 8
+  void align(std::size_t written);
+
+  /// Hands the content of the buffer to the stream
+  void flush();
+};
+
+} // namespace CYK
+
+#endif//CYK__BUFFEREDWRITER_H_
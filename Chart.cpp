@@ -0,0 +1,149 @@
+//============================================================================
+// Name        : Chart.cpp
+// Author      : Tobias Wilfert
+//============================================================================
+
+#include "Chart.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+CYK::Chart::Chart(std::vector<std::string> symbols, std::size_t size)
+    : symbols(std::move(symbols)), size(size) {
+  for(std::size_t v = 0; v < this->symbols.size(); ++v){
+    indices[this->symbols[v]] = v;
+  }
+  words = (this->symbols.size() + 63) / 64;
+  cells.assign(size * (size + 1) / 2 * words, 0);
+}
+
+CYK::Chart::Chart(const Table &table, std::vector<std::string> symbols)
+    : Chart(std::move(symbols), table.size()) {
+  for(std::size_t i = 0; i < table.size(); ++i){
+    for(std::size_t j = 0; j < table[i].size(); ++j){
+      for(auto& var: table[i][j]){
+        long symbol = symbolIndex(var);
+        if(symbol < 0){
+          throw std::invalid_argument("Unknown variable in table: " + var);
+        }
+        set(i, j, symbol);
+      }
+    }
+  }
+}
+
+void CYK::Chart::reset(std::size_t size) {
+  this->size = size;
+  const std::size_t count = size * (size + 1) / 2 * words;
+  if(count > cells.capacity()){
+    cells.reserve(std::max(count, 2 * cells.capacity()));
+  }
+  cells.assign(count, 0);
+}
+
+long CYK::Chart::symbolIndex(const std::string &variable) const {
+  auto it = indices.find(variable);
+  return it == indices.end() ? -1 : static_cast<long>(it->second);
+}
+
+std::size_t CYK::Chart::offset(std::size_t i, std::size_t j) const {
+  // Row r has size-r cells, so the rows before row i hold i*size - i*(i-1)/2
+  return (i * size - i * (i - 1) / 2 + j) * words;
+}
+
+const std::uint64_t *CYK::Chart::cell(std::size_t i, std::size_t j) const {
+  return cells.data() + offset(i, j);
+}
+
+std::uint64_t *CYK::Chart::cell(std::size_t i, std::size_t j) {
+  return cells.data() + offset(i, j);
+}
+
+bool CYK::Chart::derives(std::size_t symbol, std::size_t begin,
+                         std::size_t end) const {
+  if(begin >= end || end > size || symbol >= symbols.size()){ return false; }
+  return test(end - begin - 1, begin, symbol);
+}
+
+bool CYK::Chart::derives(const std::string &variable, std::size_t begin,
+                         std::size_t end) const {
+  long symbol = symbolIndex(variable);
+  return symbol >= 0 && derives(symbol, begin, end);
+}
+
+std::vector<CYK::Span> CYK::Chart::maximalSpans(std::size_t symbol) const {
+  std::vector<Span> result;
+  // The longest span starting at a position is the only candidate there, it is
+  // maximal if no span starting earlier reaches as far
+  std::size_t reach = 0;
+  for(std::size_t begin = 0; begin < size; ++begin){
+    for(std::size_t end = size; end > begin && end > reach; --end){
+      if(derives(symbol, begin, end)){
+        result.emplace_back(begin, end);
+        reach = end;
+        break;
+      }
+    }
+  }
+  return result;
+}
+
+void CYK::Chart::set(std::size_t i, std::size_t j, std::size_t symbol) {
+  cell(i, j)[symbol / 64] |= std::uint64_t{1} << (symbol % 64);
+}
+
+bool CYK::Chart::test(std::size_t i, std::size_t j, std::size_t symbol) const {
+  return (cell(i, j)[symbol / 64] >> (symbol % 64)) & 1;
+}
+
+std::size_t CYK::Chart::count(std::size_t i, std::size_t j) const {
+  std::size_t result = 0;
+  const std::uint64_t* words = cell(i, j);
+  for(std::size_t w = 0; w < this->words; ++w){ result += popcount(words[w]); }
+  return result;
+}
+
+std::size_t CYK::Chart::count() const {
+  std::size_t result = 0;
+  for(std::uint64_t word: cells){ result += popcount(word); }
+  return result;
+}
+
+std::size_t CYK::Chart::popcount(std::uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_popcountll(word);
+#else
+  std::size_t result = 0;
+  for(; word; word &= word - 1){ ++result; }
+  return result;
+#endif
+}
+
+CYK::Table CYK::Chart::toTable() const {
+  Table table;
+  for(std::size_t i = 0; i < size; ++i){
+    table.emplace_back(size - i);
+    for(std::size_t j = 0; j < size - i; ++j){
+      for(std::size_t v = 0; v < symbols.size(); ++v){
+        if(test(i, j, v)){ table[i][j].insert(symbols[v]); }
+      }
+    }
+  }
+  return table;
+}
+
+const std::vector<std::string> &CYK::Chart::getSymbols() const {
+  return symbols;
+}
+
+std::size_t CYK::Chart::getSize() const {
+  return size;
+}
+
+std::size_t CYK::Chart::getWords() const {
+  return words;
+}
+
+const std::vector<std::uint64_t> &CYK::Chart::getCells() const {
+  return cells;
+}
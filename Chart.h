@@ -0,0 +1,150 @@
+//============================================================================
+// Name        : Chart.h
+// Author      : Tobias Wilfert
+//============================================================================
+
+#ifndef CYK__CHART_H_
+#define CYK__CHART_H_
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include <unordered_map>
+
+#include "ContextFreeGrammar.h"
+
+namespace CYK{
+
+/// A substring of the input given by its begin and (exclusive) end
+using Span = std::pair<std::size_t, std::size_t>;
+
+/**
+ * A compact CYK table where every cell is a bitset over the variables
+ *
+ * The cells are stored in the same order as a Table: row by row (substrings
+ * of length 1 first) and within a row from left to right. Every cell takes
+ * getWords() 64-bit words, bit v of a cell is set if variable v (an index into
+ * getSymbols()) can produce the substring of the cell.
+ */
+class Chart {
+ private:
+  /// The variables, the index of a variable is its bit in a cell
+  std::vector<std::string> symbols;
+
+  /// Maps the variables to their index
+  std::unordered_map<std::string, std::size_t> indices;
+
+  /// The length of the input
+  std::size_t size = 0;
+
+  /// The number of 64-bit words per cell
+  std::size_t words = 0;
+
+  /// The cells of the table
+  std::vector<std::uint64_t> cells;
+
+ public:
+  /**
+   * Creates a chart without any variables in its cells
+   * @param symbols The variables that can occur in the cells
+   * @param size The length of the input
+   */
+  Chart(std::vector<std::string> symbols, std::size_t size);
+
+  /**
+   * Creates a chart from a filled in table
+   * @param table The table
+   * @param symbols The variables that can occur in the cells
+   * @throws std::invalid_argument If the table contains an unknown variable
+   */
+  Chart(const Table& table, std::vector<std::string> symbols);
+
+  /**
+   * Get the index of a variable
+   * @param variable The variable
+   * @return The index of variable or -1 if it is not a variable of the chart
+   */
+  long symbolIndex(const std::string& variable) const;
+
+  /**
+   * Get the position of the first word of a cell in getCells()
+   * @param i The row of the cell (the length of the substring minus one)
+   * @param j The column of the cell (the start of the substring)
+   */
+  std::size_t offset(std::size_t i, std::size_t j) const;
+
+  /// @return The first word of cell (i,j)
+  const std::uint64_t* cell(std::size_t i, std::size_t j) const;
+
+  /// @return The first word of cell (i,j)
+  std::uint64_t* cell(std::size_t i, std::size_t j);
+
+  /**
+   * Checks whether a variable can produce a substring of the input in O(1)
+   * @param symbol The index of the variable
+   * @param begin The position of the first character of the substring
+   * @param end The position after the last character of the substring
+   * @return Whether the variable can produce input[begin, end)
+   */
+  bool derives(std::size_t symbol, std::size_t begin, std::size_t end) const;
+
+  /**
+   * Checks whether a variable can produce a substring of the input
+   * @param variable The variable
+   * @param begin The position of the first character of the substring
+   * @param end The position after the last character of the substring
+   * @return Whether the variable can produce input[begin, end)
+   */
+  bool derives(const std::string& variable, std::size_t begin,
+               std::size_t end) const;
+
+  /**
+   * Get the maximal substrings a variable can produce, substrings that are not
+   * contained in a longer substring the variable can also produce
+   * @param symbol The index of the variable
+   * @return The maximal spans ordered by their begin
+   */
+  std::vector<Span> maximalSpans(std::size_t symbol) const;
+
+  /**
+   * Removes all variables from the cells and changes the length of the input,
+   * the cells only move to new memory if they need to grow
+   * @param size The length of the input
+   */
+  void reset(std::size_t size);
+
+  /// Adds a variable to cell (i,j)
+  void set(std::size_t i, std::size_t j, std::size_t symbol);
+
+  /// @return Whether cell (i,j) contains a variable
+  bool test(std::size_t i, std::size_t j, std::size_t symbol) const;
+
+  /// @return The number of variables in cell (i,j)
+  std::size_t count(std::size_t i, std::size_t j) const;
+
+  /// @return The number of variables in all the cells together
+  std::size_t count() const;
+
+  /// @return The number of bits set in word
+  static std::size_t popcount(std::uint64_t word);
+
+  /// @return The chart as a Table
+  Table toTable() const;
+
+  /// @return The variables of the chart
+  const std::vector<std::string>& getSymbols() const;
+
+  /// @return The length of the input
+  std::size_t getSize() const;
+
+  /// @return The number of 64-bit words per cell
+  std::size_t getWords() const;
+
+  /// @return All the cells of the chart
+  const std::vector<std::uint64_t>& getCells() const;
+};
+
+} // namespace CYK
+
+#endif//CYK__CHART_H_
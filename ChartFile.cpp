@@ -0,0 +1,433 @@
+//============================================================================
+// Name        : ChartFile.cpp
+// Author      : Tobias Wilfert
+//============================================================================
+
+#include "ChartFile.h"
+
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define CYK_HAS_MMAP 1
+#endif
+
+#include "Hash.h"
+#include "BufferedWriter.h"
+
+namespace {
+
+/// @return value rounded up to a multiple of 8
+std::size_t padded(std::size_t value) {
+  return (value + 7) / 8 * 8;
+}
+
+/// Reads a little endian u64
+std::uint64_t load(const unsigned char* data) {
+  std::uint64_t value = 0;
+  for(std::size_t byte = 0; byte < 8; ++byte){
+    value |= static_cast<std::uint64_t>(data[byte]) << (8 * byte);
+  }
+  return value;
+}
+
+} // namespace
+
+const char CYK::ChartFile::magic[8] = {'C', 'Y', 'K', 'C', 'H', 'A', 'R', 'T'};
+
+std::size_t CYK::ChartFile::write(std::ostream &out, const std::string &input,
+                                  const CYK::Chart &chart, bool accepted,
+                                  const CYK::ContextFreeGrammar *grammar) {
+  const std::vector<std::string>& symbols = chart.getSymbols();
+  const std::size_t size = chart.getSize();
+  const std::size_t cellCount = size * (size + 1) / 2;
+
+  // All offsets are known up front, so the file is written front to back
+  std::size_t symbolsBytes = 0;
+  for(auto& symbol: symbols){ symbolsBytes += 4 + symbol.size(); }
+  const std::size_t symbolsOffset = headerSize;
+  const std::size_t inputOffset = symbolsOffset + padded(symbolsBytes);
+  const std::size_t cellsOffset = inputOffset + padded(input.size());
+  const std::size_t cellsEnd = cellsOffset + chart.getCells().size() * 8;
+  const std::size_t indexOffset = grammar ? cellsEnd : 0;
+  const std::size_t backpointersOffset =
+      grammar ? indexOffset + cellCount * 8 : 0;
+  const std::size_t backpointerCount = grammar ? chart.count() : 0;
+  const std::size_t total = grammar ?
+      backpointersOffset + padded(backpointerCount * 12) : cellsEnd;
+
+  BufferedWriter writer{out};
+  writer.write(magic, sizeof(magic));
+  writer.writeLittleEndian<std::uint32_t>(version);
+  writer.writeLittleEndian<std::uint32_t>(
+      (accepted ? acceptedFlag : 0) | (grammar ? backpointersFlag : 0));
+  for(std::uint64_t field: {std::uint64_t{size},
+                            std::uint64_t{symbols.size()},
+                            std::uint64_t{chart.getWords()},
+                            std::uint64_t{symbolsOffset},
+                            std::uint64_t{inputOffset},
+                            std::uint64_t{cellsOffset},
+                            std::uint64_t{indexOffset},
+                            std::uint64_t{backpointersOffset},
+                            std::uint64_t{backpointerCount}}){
+    writer.writeLittleEndian(field);
+  }
+
+  for(auto& symbol: symbols){
+    writer.writeLittleEndian<std::uint32_t>(symbol.size());
+    writer.write(symbol);
+  }
+  writer.align(symbolsBytes);
+  writer.write(input);
+  writer.align(input.size());
+  for(std::uint64_t word: chart.getCells()){ writer.writeLittleEndian(word); }
+  if(!grammar){ return total; }
+
+  std::uint64_t first = 0;
+  for(std::size_t i = 0; i < size; ++i){
+    for(std::size_t j = 0; j < size - i; ++j){
+      writer.writeLittleEndian(first);
+      first += chart.count(i, j);
+    }
+  }
+
+  // The binary productions of every variable by index
+  std::vector<std::vector<std::pair<long, long>>> binary(symbols.size());
+  for(auto& production: grammar->getProductions().getProductions()){
+    long head = chart.symbolIndex(production.first);
+    if(head < 0){ continue; }
+    for(auto& rep: production.second){
+      if(rep.size() != 2){ continue; }
+      long left = chart.symbolIndex(rep[0]), right = chart.symbolIndex(rep[1]);
+      if(left >= 0 && right >= 0){ binary[head].emplace_back(left, right); }
+    }
+  }
+  for(std::size_t i = 0; i < size; ++i){
+    for(std::size_t j = 0; j < size - i; ++j){
+      for(std::size_t v = 0; v < symbols.size(); ++v){
+        if(!chart.test(i, j, v)){ continue; }
+        Backpointer backpointer{Backpointer::terminal, 0, 0};
+        for(std::size_t k = 0; k < i && backpointer.split ==
+            Backpointer::terminal; ++k){ // Looking at (k,j) (i-k-1,j+k+1)
+          for(auto& rule: binary[v]){
+            if(chart.test(k, j, rule.first) &&
+               chart.test(i-k-1, j+k+1, rule.second)){
+              backpointer = {static_cast<std::uint32_t>(k),
+                             static_cast<std::uint32_t>(rule.first),
+                             static_cast<std::uint32_t>(rule.second)};
+              break;
+            }
+          }
+        }
+        writer.writeLittleEndian(backpointer.split);
+        writer.writeLittleEndian(backpointer.left);
+        writer.writeLittleEndian(backpointer.right);
+      }
+    }
+  }
+  writer.align(backpointerCount * 12);
+  return total;
+}
+
+CYK::FileMapping::FileMapping(const std::string &path) {
+#ifdef CYK_HAS_MMAP
+  int fd = open(path.c_str(), O_RDONLY);
+  if(fd < 0){ throw std::runtime_error("Could not open " + path); }
+  struct stat status{};
+  if(fstat(fd, &status) != 0){
+    close(fd);
+    throw std::runtime_error("Could not stat " + path);
+  }
+  length = status.st_size;
+  if(length > 0){
+    void* mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(mapping == MAP_FAILED){
+      throw std::runtime_error("Could not map " + path);
+    }
+    data = static_cast<const unsigned char*>(mapping);
+    mapped = true;
+  }else{
+    close(fd);
+  }
+#else
+  std::ifstream in(path, std::ios::binary);
+  if(!in){ throw std::runtime_error("Could not open " + path); }
+  buffer.assign(std::istreambuf_iterator<char>(in),
+                std::istreambuf_iterator<char>());
+  data = buffer.data();
+  length = buffer.size();
+#endif
+}
+
+CYK::FileMapping::~FileMapping() {
+#ifdef CYK_HAS_MMAP
+  if(mapped){ munmap(const_cast<unsigned char*>(data), length); }
+#endif
+}
+
+const unsigned char *CYK::FileMapping::getData() const {
+  return data;
+}
+
+std::size_t CYK::FileMapping::getLength() const {
+  return length;
+}
+
+CYK::MappedChart::MappedChart(const std::string &path)
+    : mapping(std::make_unique<FileMapping>(path)),
+      data(mapping->getData()), length(mapping->getLength()) {
+  parse();
+}
+
+CYK::MappedChart::MappedChart(const unsigned char *data, std::size_t length)
+    : data(data), length(length) {
+  parse();
+}
+
+template<typename T>
+T CYK::MappedChart::load(std::size_t position) const {
+  T value = 0;
+  for(std::size_t byte = 0; byte < sizeof(T); ++byte){
+    value |= static_cast<T>(data[position + byte]) << (8 * byte);
+  }
+  return value;
+}
+
+void CYK::MappedChart::parse() {
+  auto fail = [](const std::string& reason){
+    throw std::runtime_error("Invalid chart file: " + reason);
+  };
+  if(length < ChartFile::headerSize){ fail("too short"); }
+  for(std::size_t c = 0; c < sizeof(ChartFile::magic); ++c){
+    if(data[c] != static_cast<unsigned char>(ChartFile::magic[c])){
+      fail("wrong magic");
+    }
+  }
+  if(load<std::uint32_t>(8) != ChartFile::version){
+    fail("unsupported version " + std::to_string(load<std::uint32_t>(8)));
+  }
+  flags = load<std::uint32_t>(12);
+  const std::uint64_t fileSize = load<std::uint64_t>(16);
+  const std::uint64_t symbolCount = load<std::uint64_t>(24);
+  const std::uint64_t fileWords = load<std::uint64_t>(32);
+  const std::uint64_t symbolsOffset = load<std::uint64_t>(40);
+  const std::uint64_t inputOffset = load<std::uint64_t>(48);
+  cellsOffset = load<std::uint64_t>(56);
+  indexOffset = load<std::uint64_t>(64);
+  backpointersOffset = load<std::uint64_t>(72);
+  const std::uint64_t backpointerCount = load<std::uint64_t>(80);
+
+  // Every check is done such that corrupt values can not overflow
+  auto fits = [this](std::uint64_t offset, std::uint64_t count,
+                     std::uint64_t bytes){
+    return offset <= length && count <= (length - offset) / bytes;
+  };
+  if(fileSize > 0xffffffff || symbolCount > 0xffffffff){ fail("too large"); }
+  if(fileWords != (symbolCount + 63) / 64){ fail("wrong cell size"); }
+  size = fileSize;
+  words = fileWords;
+  const std::uint64_t cellCount = size * (size + 1) / 2;
+  if(words > 0 && !fits(cellsOffset, cellCount, 8 * words)){
+    fail("cells out of bounds");
+  }
+  if(hasBackpointers() && (!fits(indexOffset, cellCount, 8) ||
+                           !fits(backpointersOffset, backpointerCount, 12))){
+    fail("backpointers out of bounds");
+  }
+
+  std::size_t position = symbolsOffset;
+  for(std::uint64_t v = 0; v < symbolCount; ++v){
+    if(!fits(position, 1, 4)){ fail("variables out of bounds"); }
+    std::uint32_t symbolLength = load<std::uint32_t>(position);
+    position += 4;
+    if(!fits(position, symbolLength, 1)){ fail("variables out of bounds"); }
+    symbols.emplace_back(reinterpret_cast<const char*>(data) + position,
+                         symbolLength);
+    position += symbolLength;
+  }
+  if(!fits(inputOffset, size, 1)){ fail("input out of bounds"); }
+  input.assign(reinterpret_cast<const char*>(data) + inputOffset, size);
+}
+
+std::size_t CYK::MappedChart::wordIndex(std::size_t i, std::size_t j) const {
+  return (i * size - i * (i - 1) / 2 + j) * words;
+}
+
+bool CYK::MappedChart::derives(std::size_t symbol, std::size_t begin,
+                               std::size_t end) const {
+  if(begin >= end || end > size || symbol >= symbols.size()){ return false; }
+  std::size_t word = wordIndex(end - begin - 1, begin) + symbol / 64;
+  return (load<std::uint64_t>(cellsOffset + word * 8) >> (symbol % 64)) & 1;
+}
+
+bool CYK::MappedChart::getBackpointer(std::size_t i, std::size_t j,
+                                      std::size_t symbol,
+                                      Backpointer &backpointer) const {
+  if(!hasBackpointers() || !derives(symbol, j, j + i + 1)){ return false; }
+  const std::size_t cell = wordIndex(i, j) / words;
+  std::uint64_t index = load<std::uint64_t>(indexOffset + cell * 8);
+  // The index comes from the file, checked before it is multiplied so a
+  // corrupt one can not wrap around
+  if(backpointersOffset > length){ return false; }
+  const std::uint64_t count = (length - backpointersOffset) / 12;
+  if(index >= count){ return false; }
+  // Count the variables before symbol in the cell
+  const std::size_t first = cellsOffset + wordIndex(i, j) * 8;
+  for(std::size_t w = 0; w <= symbol / 64; ++w){
+    std::uint64_t word = load<std::uint64_t>(first + w * 8);
+    if(w == symbol / 64){
+      word &= (std::uint64_t{1} << (symbol % 64)) - 1;
+    }
+    index += Chart::popcount(word);
+  }
+  if(index >= count){ return false; }
+  const std::size_t position = backpointersOffset + index * 12;
+  backpointer = {load<std::uint32_t>(position),
+                 load<std::uint32_t>(position + 4),
+                 load<std::uint32_t>(position + 8)};
+  return true;
+}
+
+long CYK::MappedChart::symbolIndex(const std::string &variable) const {
+  for(std::size_t v = 0; v < symbols.size(); ++v){
+    if(symbols[v] == variable){ return v; }
+  }
+  return -1;
+}
+
+CYK::Chart CYK::MappedChart::toChart() const {
+  Chart chart{symbols, size};
+  for(std::size_t i = 0; i < size; ++i){
+    for(std::size_t j = 0; j < size - i; ++j){
+      std::uint64_t* cell = chart.cell(i, j);
+      const std::size_t first = cellsOffset + wordIndex(i, j) * 8;
+      for(std::size_t w = 0; w < words; ++w){
+        cell[w] = load<std::uint64_t>(first + w * 8);
+      }
+    }
+  }
+  return chart;
+}
+
+const std::string &CYK::MappedChart::getInput() const {
+  return input;
+}
+
+const std::vector<std::string> &CYK::MappedChart::getSymbols() const {
+  return symbols;
+}
+
+bool CYK::MappedChart::isAccepted() const {
+  return flags & ChartFile::acceptedFlag;
+}
+
+bool CYK::MappedChart::hasBackpointers() const {
+  return flags & ChartFile::backpointersFlag;
+}
+
+const char CYK::ChartContainer::magic[8] =
+    {'C', 'Y', 'K', 'C', 'N', 'T', 'N', 'R'};
+
+const char CYK::ChartContainer::footerMagic[8] =
+    {'C', 'Y', 'K', 'I', 'N', 'D', 'E', 'X'};
+
+CYK::ChartContainer::ChartContainer(const std::string &path)
+    : out(path, std::ios::out | std::ios::binary) {
+  if(!out){ throw std::runtime_error("Could not create " + path); }
+  BufferedWriter writer{out};
+  writer.write(magic, sizeof(magic));
+  writer.writeLittleEndian<std::uint32_t>(version);
+  writer.writeLittleEndian<std::uint32_t>(0);
+  position = 16;
+}
+
+CYK::ChartContainer::~ChartContainer() {
+  close();
+}
+
+void CYK::ChartContainer::add(const std::string &input,
+                              const CYK::Chart &chart, bool accepted,
+                              const CYK::ContextFreeGrammar *grammar) {
+  std::size_t length = ChartFile::write(out, input, chart, accepted, grammar);
+  index.push_back(position);
+  index.push_back(length);
+  index.push_back(hash(input));
+  position += length;
+}
+
+void CYK::ChartContainer::close() {
+  if(closed){ return; }
+  closed = true;
+  BufferedWriter writer{out};
+  for(std::uint64_t field: index){ writer.writeLittleEndian(field); }
+  writer.writeLittleEndian(position);
+  writer.writeLittleEndian<std::uint64_t>(index.size() / 3);
+  writer.write(footerMagic, sizeof(footerMagic));
+  writer.flush();
+  out.close();
+}
+
+CYK::MappedContainer::MappedContainer(const std::string &path)
+    : mapping(path) {
+  const unsigned char* data = mapping.getData();
+  const std::size_t length = mapping.getLength();
+  auto fail = [](const std::string& reason){
+    throw std::runtime_error("Invalid container file: " + reason);
+  };
+  if(length < 16 + 24 ||
+     !std::equal(ChartContainer::magic, ChartContainer::magic + 8, data) ||
+     !std::equal(ChartContainer::footerMagic, ChartContainer::footerMagic + 8,
+                 data + length - 8)){
+    fail("wrong magic or missing index");
+  }
+  indexOffset = load(data + length - 24);
+  count = load(data + length - 16);
+  if(indexOffset > length - 24 || count > (length - 24 - indexOffset) / 24){
+    fail("index out of bounds");
+  }
+  for(std::size_t record = 0; record < count; ++record){
+    if(entry(record, 0) > indexOffset ||
+       entry(record, 1) > indexOffset - entry(record, 0)){
+      fail("record out of bounds");
+    }
+  }
+}
+
+std::uint64_t CYK::MappedContainer::entry(std::size_t record,
+                                          std::size_t field) const {
+  return load(mapping.getData() + indexOffset + (record * 3 + field) * 8);
+}
+
+std::size_t CYK::MappedContainer::size() const {
+  return count;
+}
+
+CYK::MappedChart CYK::MappedContainer::record(std::size_t record) const {
+  if(record >= count){
+    throw std::out_of_range("No record " + std::to_string(record));
+  }
+  return MappedChart{mapping.getData() + entry(record, 0),
+                     static_cast<std::size_t>(entry(record, 1))};
+}
+
+long CYK::MappedContainer::find(const std::string &input) const {
+  const std::uint64_t inputHash = hash(input);
+  for(std::size_t r = 0; r < count; ++r){
+    if(entry(r, 2) == inputHash && record(r).getInput() == input){ return r; }
+  }
+  return -1;
+}
+
+bool CYK::MappedContainer::isContainer(const std::string &path) {
+  std::ifstream in(path, std::ios::binary);
+  char start[8] = {};
+  in.read(start, sizeof(start));
+  return in && std::equal(start, start + 8, ChartContainer::magic);
+}
@@ -0,0 +1,330 @@
+//============================================================================
+// Name        : ChartFile.h
+// Author      : Tobias Wilfert
+//============================================================================
+
+#ifndef CYK__CHARTFILE_H_
+#define CYK__CHARTFILE_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <fstream>
+#include <ostream>
+
+#include "Chart.h"
+#include "ContextFreeGrammar.h"
+
+namespace CYK{
+
+/// How a variable produced the substring of a cell
+struct Backpointer {
+  /// The length minus one of the left substring, terminal for terminals
+  std::uint32_t split;
+
+  /// The index of the left variable of the production
+  std::uint32_t left;
+
+  /// The index of the right variable of the production
+  std::uint32_t right;
+
+  /// The split of a variable that produces a terminal
+  static constexpr std::uint32_t terminal = 0xffffffff;
+};
+
+/**
+ * The on-disk format of a filled in chart (version 1)
+ *
+ * All integers are little endian and all sections start at a multiple of 8:
+ *   header:        "CYKCHART", u32 version, u32 flags (bit 0: accepted,
+ *                  bit 1: has backpointers), u64 input length, u64 number of
+ *                  variables, u64 words per cell, u64 offsets of the
+ *                  variables, input, cells, backpointer index and backpointers
+ *                  (the last two 0 without backpointers), u64 backpointers
+ *   variables:     u32 length followed by the characters, for every variable
+ *   input:         the characters of the input
+ *   cells:         the cells of the Chart in order, u64 words each
+ *   index:         for every cell the u64 index of its first backpointer
+ *   backpointers:  u32 split, u32 left, u32 right for every variable of every
+ *                  cell, in order of the cells and then the variables
+ */
+class ChartFile {
+ public:
+  /// The first 8 bytes of a chart file
+  static const char magic[8];
+
+  /// The version written by write
+  static constexpr std::uint32_t version = 1;
+
+  /// The size of the header in bytes
+  static constexpr std::size_t headerSize = 88;
+
+  /// Flag set if the input is accepted
+  static constexpr std::uint32_t acceptedFlag = 1;
+
+  /// Flag set if the file has backpointers
+  static constexpr std::uint32_t backpointersFlag = 2;
+
+  /**
+   * Writes a chart in one sequential pass
+   * @param out The stream, should be opened in binary mode
+   * @param input The input string of the chart
+   * @param chart The filled in chart
+   * @param accepted Whether input is in the language of the CFG
+   * @param grammar If not null, used to add a backpointer for every variable
+   * @return The number of bytes written, always a multiple of 8
+   */
+  static std::size_t write(std::ostream& out, const std::string& input,
+                           const Chart& chart, bool accepted,
+                           const ContextFreeGrammar* grammar = nullptr);
+};
+
+/// A read-only file mapped into memory (read into memory where mmap is missing)
+class FileMapping {
+ private:
+  /// The content of the file
+  const unsigned char* data = nullptr;
+
+  /// The size of the file in bytes
+  std::size_t length = 0;
+
+  /// The content of the file if it could not be mapped
+  std::vector<unsigned char> buffer;
+
+  /// Whether data is a mapping that needs to be unmapped
+  bool mapped = false;
+
+ public:
+  /**
+   * Maps a file
+   * @param path The path of the file
+   * @throws std::runtime_error If the file can't be read
+   */
+  explicit FileMapping(const std::string& path);
+
+  FileMapping(const FileMapping&) = delete;
+  FileMapping& operator=(const FileMapping&) = delete;
+
+  /// Unmaps the file
+  ~FileMapping();
+
+  /// @return The content of the file
+  const unsigned char* getData() const;
+
+  /// @return The size of the file in bytes
+  std::size_t getLength() const;
+};
+
+/**
+ * A chart file mapped into memory
+ *
+ * Queries read straight from the mapping so opening a chart is independent of
+ * its size, only the variables and the input are copied.
+ */
+class MappedChart {
+ private:
+  /// The mapping, if the chart owns it
+  std::unique_ptr<FileMapping> mapping;
+
+  /// The content of the chart file
+  const unsigned char* data = nullptr;
+
+  /// The size of the chart file in bytes
+  std::size_t length = 0;
+
+  /// The flags from the header
+  std::uint32_t flags = 0;
+
+  /// The length of the input
+  std::size_t size = 0;
+
+  /// The number of 64-bit words per cell
+  std::size_t words = 0;
+
+  /// The offsets of the sections
+  std::size_t cellsOffset = 0, indexOffset = 0, backpointersOffset = 0;
+
+  /// The variables
+  std::vector<std::string> symbols;
+
+  /// The input
+  std::string input;
+
+  /// Reads the header and validates the file
+  void parse();
+
+  /// Reads an unsigned little endian integer at a position in the file
+  template<typename T> T load(std::size_t position) const;
+
+  /// @return The index of the first word of cell (i,j) among all words
+  std::size_t wordIndex(std::size_t i, std::size_t j) const;
+
+ public:
+  /**
+   * Maps a chart file
+   * @param path The path of the file
+   * @throws std::runtime_error If the file can't be read or is no chart file
+   */
+  explicit MappedChart(const std::string& path);
+
+  /**
+   * Reads a chart file that is already in memory, without copying it
+   * @param data The content of the chart file, needs to outlive the chart
+   * @param length The size of the chart file in bytes
+   * @throws std::runtime_error If the data is no chart file
+   */
+  MappedChart(const unsigned char* data, std::size_t length);
+
+  MappedChart(MappedChart&&) = default;
+  MappedChart& operator=(MappedChart&&) = default;
+
+  /**
+   * Checks whether a variable can produce a substring of the input in O(1)
+   * @param symbol The index of the variable
+   * @param begin The position of the first character of the substring
+   * @param end The position after the last character of the substring
+   * @return Whether the variable can produce input[begin, end)
+   */
+  bool derives(std::size_t symbol, std::size_t begin, std::size_t end) const;
+
+  /**
+   * Get how a variable produced the substring of a cell
+   * @param i The row of the cell
+   * @param j The column of the cell
+   * @param symbol The index of the variable
+   * @param backpointer Is set to the backpointer if there is one
+   * @return Whether the file has a backpointer for the variable in the cell
+   */
+  bool getBackpointer(std::size_t i, std::size_t j, std::size_t symbol,
+                      Backpointer& backpointer) const;
+
+  /// @return The index of a variable or -1 if it is not in the chart
+  long symbolIndex(const std::string& variable) const;
+
+  /// @return The chart as a Chart
+  Chart toChart() const;
+
+  /// @return The input of the chart
+  const std::string& getInput() const;
+
+  /// @return The variables of the chart
+  const std::vector<std::string>& getSymbols() const;
+
+  /// @return Whether the input is in the language of the CFG
+  bool isAccepted() const;
+
+  /// @return Whether the file has backpointers
+  bool hasBackpointers() const;
+};
+
+/**
+ * Writes many charts into a single container file, so a run writes one file
+ * sequentially instead of creating a file per input
+ *
+ * Layout (integers are little endian):
+ *   header:   "CYKCNTNR", u32 version (1), u32 0
+ *   records:  a chart file (see ChartFile) per input, in the order added
+ *   index:    for every record u64 offset, u64 length, u64 hash of the input
+ *   footer:   u64 offset of the index, u64 number of records, "CYKINDEX"
+ * The index and footer are written by close.
+ */
+class ChartContainer {
+ private:
+  /// The container file
+  std::ofstream out;
+
+  /// The number of bytes written so far
+  std::uint64_t position = 0;
+
+  /// The offset, length and input hash of every record
+  std::vector<std::uint64_t> index;
+
+  /// Whether the index has been written
+  bool closed = false;
+
+ public:
+  /// The first 8 bytes of a container file
+  static const char magic[8];
+
+  /// The last 8 bytes of a complete container file
+  static const char footerMagic[8];
+
+  /// The version written
+  static constexpr std::uint32_t version = 1;
+
+  /**
+   * Creates the container file and writes its header
+   * @param path The path of the file
+   * @throws std::runtime_error If the file can't be created
+   */
+  explicit ChartContainer(const std::string& path);
+
+  /// Closes the container if that did not happen yet
+  ~ChartContainer();
+
+  /**
+   * Appends a chart
+   * @param input The input string of the chart
+   * @param chart The filled in chart
+   * @param accepted Whether input is in the language of the CFG
+   * @param grammar If not null, used to add a backpointer for every variable
+   */
+  void add(const std::string& input, const Chart& chart, bool accepted,
+           const ContextFreeGrammar* grammar = nullptr);
+
+  /// Writes the index and the footer
+  void close();
+};
+
+/// A container file (see ChartContainer) mapped into memory
+class MappedContainer {
+ private:
+  /// The mapping of the file
+  FileMapping mapping;
+
+  /// The offset of the index
+  std::size_t indexOffset = 0;
+
+  /// The number of records
+  std::size_t count = 0;
+
+  /// Reads an index entry (0 offset, 1 length, 2 hash) of a record
+  std::uint64_t entry(std::size_t record, std::size_t field) const;
+
+ public:
+  /**
+   * Maps a container file
+   * @param path The path of the file
+   * @throws std::runtime_error If the file can't be read or is no container
+   */
+  explicit MappedContainer(const std::string& path);
+
+  /// @return The number of charts in the container
+  std::size_t size() const;
+
+  /**
+   * Get a chart of the container, reading from the mapping of the container
+   * @param record The index of the chart
+   * @return The chart, only valid as long as the container is
+   */
+  MappedChart record(std::size_t record) const;
+
+  /**
+   * Finds the chart of an input
+   * @param input The input
+   * @return The index of the (first) chart of input or -1 if there is none
+   */
+  long find(const std::string& input) const;
+
+  /**
+   * Checks whether a file is a container file
+   * @param path The path of the file
+   * @return Whether the file starts like a container file
+   */
+  static bool isContainer(const std::string& path);
+};
+
+} // namespace CYK
+
+#endif//CYK__CHARTFILE_H_
@@ -4,16 +4,75 @@
 //============================================================================
 
 #include "ContextFreeGrammar.h"
+#include "Hash.h"
+#include "Chart.h"
+#include "OutputSink.h"
+#include "Instrumentation.h"
+#include "PerfCounters.h"
+#include "Trace.h"
+#include "ParserContext.h"
+#include "BitsetParser.h"
+
+#include "WeightedParser.h"
+
+#include <chrono>
+#include <algorithm>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+namespace {
+
+/// @return The size of the L2 cache in bytes, 0 if it is unknown
+std::size_t cacheSize() {
+#if defined(__linux__) && defined(_SC_LEVEL2_CACHE_SIZE)
+  const long size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+  return size > 0 ? static_cast<std::size_t>(size) : 0;
+#else
+  return 0;
+#endif
+}
+
+} // namespace
 
 void CYK::Productions::addProduction(const std::string &variable,
-                                     const CYK::Replacement &replacement) {
+                                     const CYK::Replacement &replacement,
+                                     double weight) {
   productions[variable].insert(replacement);
   reverseProductions[replacement].insert(variable);
+  weights[{variable, replacement}] = weight;
 }
 
 std::set<std::string> CYK::Productions::getVariablesThatProduce(
-    const CYK::Replacement &replacement) {
-  return reverseProductions[replacement];
+    const CYK::Replacement &replacement) const {
+  auto it = reverseProductions.find(replacement);
+  if(it == reverseProductions.end()){ return {}; }
+  return it->second;
+}
+
+const std::set<std::string> *CYK::Productions::findVariablesThatProduce(
+    const CYK::Replacement &replacement) const {
+  auto it = reverseProductions.find(replacement);
+  return it == reverseProductions.end() ? nullptr : &it->second;
+}
+
+const std::map<std::string, std::set<CYK::Replacement>>&
+CYK::Productions::getProductions() const {
+  return productions;
+}
+
+const std::set<CYK::Replacement>& CYK::Productions::getReplacements(
+    const std::string &variable) const {
+  static const std::set<Replacement> none;
+  auto it = productions.find(variable);
+  return it == productions.end() ? none : it->second;
+}
+
+double CYK::Productions::getWeight(const std::string &variable,
+                                  const CYK::Replacement &replacement) const {
+  auto it = weights.find({variable, replacement});
+  return it == weights.end() ? 0.0 : it->second;
 }
 
 CYK::ContextFreeGrammar::ContextFreeGrammar(const json &j) {
@@ -22,86 +81,291 @@ CYK::ContextFreeGrammar::ContextFreeGrammar(const json &j) {
   terminals = j["Terminals"].get<std::unordered_set<std::string>>();
   for (auto &element : j["Productions"]) {
     productions.addProduction(element["head"],
-                              element["body"]);
+                              element["body"],
+                              element.value("weight", 1.0));
   }
-}
 
-void CYK::ContextFreeGrammar::CYK(const std::string &input) {
-  Table  table = generateCYKTable(input.size());
-  for(int i=0; i < input.size(); ++i){   // fill in the first row
-    table[0][i] = productions.getVariablesThatProduce(
-        {std::string{input.at(i)}});
+  // Every string is followed by a 0 byte so the pieces can not run together
+  fingerprint = hash(startSymbol.c_str(), startSymbol.size() + 1);
+  shortVariables = true;
+  for(auto& variable: getVariables()){
+    fingerprint = hash(variable.c_str(), variable.size() + 1, fingerprint);
+    // Names within the small string buffer are stored in the std::string
+    shortVariables &= variable.size() <= std::string().capacity();
   }
-  // Fill in the rest of the table
-  for(int i=1; i < table.size(); i++){
-    for(int j=0; j < table.size()-i; ++j){ // Looking at (i,j)
-     std::set<std::string> varsForCell;
-     for(int k=0; k < i; ++k){ // Looking at (k,j) (i-k-1,j+k+1)
-       for(const Replacement& rep: getPermutations(
-                table.at(k).at(j),table.at(i-k-1).at(j+k+1))){
-         std::set<std::string> vars = productions.getVariablesThatProduce(rep);
-         varsForCell.insert(vars.begin(),vars.end());
-       }
-     }
-     table.at(i).at(j) = varsForCell;
+  tile = defaultTile();
+  for(auto& production: productions.getProductions()){
+    fingerprint = hash(production.first.c_str(), production.first.size() + 1,
+                       fingerprint);
+    for(auto& replacement: production.second){
+      for(auto& symbol: replacement){
+        fingerprint = hash(symbol.c_str(), symbol.size() + 1, fingerprint);
+      }
+      double weight = productions.getWeight(production.first, replacement);
+      fingerprint = hash(&weight, sizeof(weight), fingerprint);
     }
   }
-  createHTMLRepresentation(input, table);
+  bitsetParser = std::make_shared<const BitsetParser>(*this);
 }
 
-CYK::Table CYK::ContextFreeGrammar::generateCYKTable(int size) {
-  Table table;
-  for(int i = 0; i < size; ++i){
-    std::vector<std::set<std::string>> row;
-    for(int j = i; j < size; ++j){ row.emplace_back(); }
-    table.push_back(row);
+bool CYK::ContextFreeGrammar::CYK(const std::string &input) {
+  HTMLSink sink;
+  return CYK(input, sink);
+}
+
+bool CYK::ContextFreeGrammar::CYK(const std::string &input,
+                                  CYK::OutputSink &sink) {
+  ParserContext& context = ParserContext::local();
+  if(sink.usesChart()){
+    const Chart& chart = bitsetParser->fill(input, context);
+    bool accepted = bitsetParser->accepts(chart);
+    CYK_PROFILE_TIME(output);
+    CYK_PERF_PHASE(PerfPhase::Output);
+    sink.writeChart(input, chart, accepted);
+    return accepted;
+  }
+  const Table& table = fillTable(input, context);
+  bool accepted = accepts(table);
+  {
+    CYK_PROFILE_TIME(output);
+    CYK_PERF_PHASE(PerfPhase::Output);
+    sink.write(input, table, accepted);
   }
+  // Frees the cells at once, otherwise they stay allocated until the next parse
+  context.clearTable();
+  return accepted;
+}
+
+bool CYK::ContextFreeGrammar::accepts(const CYK::Table &table) const {
+  return !table.empty() && table.back()[0].count(startSymbol);
+}
+
+CYK::Table CYK::ContextFreeGrammar::fillTable(const std::string &input) const {
+  Table  table = generateCYKTable(input.size());
+  fill(table, input, ParserContext::local());
+  return table;
+}
+
+const CYK::Table &CYK::ContextFreeGrammar::fillTable(
+    const std::string &input, CYK::ParserContext &context) const {
+  Table& table = context.getTable(input.size(), shortVariables);
+  fill(table, input, context);
   return table;
 }
 
-std::vector<CYK::Replacement> CYK::ContextFreeGrammar::getPermutations(
-    const std::set<std::string> &set1, const std::set<std::string> &set2) {
-  std::vector<Replacement> result;
-  for(auto& p: set1){
-    for(auto& q: set2){
-      result.push_back({p,q});
+void CYK::ContextFreeGrammar::fill(CYK::Table &table, const std::string &input,
+                                   CYK::ParserContext &context) const {
+  CYK_PROFILE_START(input.size());
+  // Fill in the table row by row, the first row holds the terminals
+  const std::size_t size = table.size();
+  const std::size_t rows = tile == 0 || size <= 2 * tile ? size : 1;
+  for(std::size_t i = 0; i < rows; ++i){
+    CYK_PROFILE_TIME(diagonals[i]);
+    CYK_PERF_PHASE(i == 0 ? PerfPhase::FirstRow : PerfPhase::Splits);
+    Trace::Span span{"diagonal", "cyk", static_cast<std::int64_t>(i)};
+    for(std::size_t j = 0; j < size - i; ++j){ // Looking at (i,j)
+      fillCell(table, input, static_cast<int>(i), static_cast<int>(j),
+               context, table.at(i).at(j));
     }
   }
-  return result;
-}
-
-void CYK::ContextFreeGrammar::createHTMLRepresentation(
-    const std::string &input, const CYK::Table &table) {
-  std::string htmlDoc = "<html lang=\"en\" >\n"
-                        "<style>\n"
-                        "  table, td { border: 1px solid black;\n"
-                        "              padding: 5px;}\n"
-                        "  html *{font-family: Arial, Helvetica, sans-serif;}\n"
-                        "</style>\n"
-                        "<table>\n";
-  htmlDoc += ("<caption>CYK table for \"" + input + "\"</caption>\n");
-  // The Main table
-  for(int i = table.size()-1; i > -1; --i){
-    htmlDoc += "  <tr>\n";
-    for(auto& col: table.at(i)){
-      htmlDoc += "    <td>";
-      for(auto& con: col){
-        htmlDoc += con + ",";
+  if(rows == size){ return; }
+  // The rest in tiles, a tile only reads tiles closer to the diagonal and
+  // itself
+  CYK_PROFILE_TIME(diagonals[1]);
+  CYK_PERF_PHASE(PerfPhase::Splits);
+  const std::size_t tiles = (size + tile - 1) / tile;
+  for(std::size_t d = 0; d < tiles; ++d){
+    Trace::Span span{"tile_diagonal", "cyk", static_cast<std::int64_t>(d)};
+    for(std::size_t t = 0; t + d < tiles; ++t){
+      fillTile(table, input, t * tile, (t + d) * tile, context);
+    }
+  }
+}
+
+void CYK::ContextFreeGrammar::fillTile(CYK::Table &table,
+                                       const std::string &input,
+                                       std::size_t begin, std::size_t end,
+                                       CYK::ParserContext &context) const {
+  const std::size_t size = table.size();
+  const std::size_t lastBegin = std::min(begin + tile, size) - 1;
+  const std::size_t lastEnd = std::min(end + tile, size) - 1;
+  // The cells (b,e) are in row e-b and column b, a split m combines (b,m)
+  // with (m+1,e). The split points from lastBegin up to end read tiles
+  // closer to the diagonal only, so they are applied a tile of split points
+  // at a time for all cells while those stay in the cache.
+  for(std::size_t m = lastBegin; m < end; m += tile){
+    const std::size_t mEnd = std::min(m + tile, end);
+    for(std::size_t b = begin; b <= lastBegin; ++b){
+      for(std::size_t e = end; e <= lastEnd; ++e){
+        fillSplits(table, e - b, b, m - b, mEnd - b, context, table[e - b][b]);
       }
-      if(htmlDoc.back() == ','){ htmlDoc.pop_back(); }
-      htmlDoc += "</td>\n";
     }
-    htmlDoc += "  </tr>\n";
   }
-  // Add the input to the bottom of the table
-  htmlDoc += "  <tr>\n";
-  for(auto& s: input){
-    htmlDoc += ("    <th>" + std::string{s} + "</th>\n");
+  // The other split points read cells of this tile itself, which are shorter
+  for(std::size_t i = end > lastBegin ? end - lastBegin : 1;
+      i <= lastEnd - begin; ++i){
+    const std::size_t first = std::max(begin, end > i ? end - i : 0);
+    const std::size_t last = std::min(lastBegin, lastEnd - i);
+    for(std::size_t b = first; b <= last; ++b){
+      if(end > lastBegin){
+        fillSplits(table, i, b, 0, lastBegin - b, context, table[i][b]);
+        fillSplits(table, i, b, end - b, i, context, table[i][b]);
+      }else{
+        fillCell(table, input, static_cast<int>(i), static_cast<int>(b),
+                 context, table[i][b]);
+      }
+    }
   }
-  htmlDoc += "  </tr>\n"
-             "</table>\n"
-             "</html>";
-  std::ofstream out("CYKTable-" + input + ".html");
-  out << htmlDoc;
-  out.close();
 }
+
+bool CYK::ContextFreeGrammar::recognize(const std::string &input) const {
+  return recognize(input, ParserContext::local());
+}
+
+bool CYK::ContextFreeGrammar::recognize(const std::string &input,
+                                        CYK::ParserContext &context) const {
+  return bitsetParser->accepts(bitsetParser->fill(input, context));
+}
+
+CYK::Chart CYK::ContextFreeGrammar::createChart(
+    const std::string &input) const {
+  return bitsetParser->fill(input);
+}
+
+const CYK::BitsetParser &CYK::ContextFreeGrammar::getBitsetParser() const {
+  return *bitsetParser;
+}
+
+CYK::TableCell CYK::ContextFreeGrammar::fillCell(
+    const CYK::Table &table, const std::string &input, int i, int j) const {
+  TableCell varsForCell;
+  fillCell(table, input, i, j, ParserContext::local(), varsForCell);
+  return varsForCell;
+}
+
+void CYK::ContextFreeGrammar::fillCell(const CYK::Table &table,
+                                       const std::string &input, int i, int j,
+                                       CYK::ParserContext &context,
+                                       CYK::TableCell &varsForCell) const {
+  if(i == 0){
+    CYK_PROFILE_TIME(firstRow);
+    Replacement& terminal = context.getTerminal();
+    terminal[0].assign(1, input.at(j));
+    const std::set<std::string>* vars =
+        productions.findVariablesThatProduce(terminal);
+    if(vars){ varsForCell.insert(vars->begin(), vars->end()); }
+    return;
+  }
+  fillSplits(table, i, j, 0, i, context, varsForCell);
+}
+
+void CYK::ContextFreeGrammar::fillSplits(const CYK::Table &table,
+                                         std::size_t i, std::size_t j,
+                                         std::size_t begin, std::size_t end,
+                                         CYK::ParserContext &context,
+                                         CYK::TableCell &varsForCell) const {
+  // The pairs are looked up in place instead of being copied into a vector
+  Replacement& pair = context.getPair();
+  for(std::size_t k = begin; k < end; ++k){ // Looking at (k,j) (i-k-1,j+k+1)
+    const TableCell& left = table.at(k).at(j);
+    const TableCell& right = table.at(i-k-1).at(j+k+1);
+    CYK_PROFILE_COUNT(splits, 1);
+    CYK_PROFILE_COUNT(candidatePairs, left.size() * right.size());
+    for(auto& p: left){
+      pair[0].assign(p);
+      for(auto& q: right){
+        pair[1].assign(q);
+        const std::set<std::string>* vars;
+        {
+          CYK_PROFILE_TIME(ruleLookups);
+          vars = productions.findVariablesThatProduce(pair);
+        }
+        if(!vars){ continue; }
+        CYK_PROFILE_COUNT(ruleHits, 1);
+        CYK_PROFILE_TIME(setUnions);
+        varsForCell.insert(vars->begin(),vars->end());
+      }
+    }
+  }
+}
+
+std::size_t CYK::ContextFreeGrammar::getTile() const {
+  return tile;
+}
+
+void CYK::ContextFreeGrammar::setTile(std::size_t tile) {
+  this->tile = tile;
+}
+
+std::size_t CYK::ContextFreeGrammar::tune(const std::string &input) {
+  using Clock = std::chrono::steady_clock;
+  ParserContext& context = ParserContext::local();
+  std::size_t best = 0;
+  double bestSeconds = -1;
+  tile = 0;
+  fillTable(input, context); // Warm up
+  for(std::size_t candidate: {0, 16, 32, 64, 128, 256}){
+    if(candidate != 0 && input.size() <= 2 * candidate){ break; }
+    tile = candidate;
+    const auto start = Clock::now();
+    fillTable(input, context);
+    const double seconds =
+        std::chrono::duration<double>(Clock::now() - start).count();
+    if(bestSeconds < 0 || seconds < bestSeconds){
+      best = candidate;
+      bestSeconds = seconds;
+    }
+  }
+  context.clearTable();
+  tile = best;
+  return tile;
+}
+
+std::size_t CYK::ContextFreeGrammar::defaultTile() {
+  static const std::size_t cache = cacheSize();
+  const std::size_t bytes = cache == 0 ? 1 << 20 : cache;
+  // A cell with a node of one variable
+  const std::size_t cell = sizeof(TableCell) + 64;
+  std::size_t size = 256;
+  while(size > 16 && 3 * size * size * cell > bytes){ size /= 2; }
+  return size;
+}
+
+const std::string &CYK::ContextFreeGrammar::getStartSymbol() const {
+  return startSymbol;
+}
+
+std::uint64_t CYK::ContextFreeGrammar::getFingerprint() const {
+  return fingerprint;
+}
+
+const CYK::Productions &CYK::ContextFreeGrammar::getProductions() const {
+  return productions;
+}
+
+std::vector<std::string> CYK::ContextFreeGrammar::getVariables() const {
+  std::set<std::string> all{variables.begin(), variables.end()};
+  for(auto& production: productions.getProductions()){
+    all.insert(production.first);
+  }
+  return {all.begin(), all.end()};
+}
+
+std::vector<CYK::Derivation> CYK::ContextFreeGrammar::parse(
+    const std::string &input, unsigned int k, const Beam &beam,
+    BeamReport *report) const {
+  WeightedParser parser{productions, startSymbol, input, beam};
+  if(report){ *report = parser.getReport(); }
+  return parser.best(k);
+}
+
+CYK::Table CYK::ContextFreeGrammar::generateCYKTable(int size) {
+  Table table;
+  for(int i = 0; i < size; ++i){
+    std::vector<TableCell> row;
+    for(int j = i; j < size; ++j){ row.emplace_back(); }
+    table.push_back(row);
+  }
+  return table;
+}
+
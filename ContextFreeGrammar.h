@@ -6,11 +6,16 @@
 #ifndef CYK__CONTEXTFREEGRAMMAR_H_
 #define CYK__CONTEXTFREEGRAMMAR_H_
 
+#include <map>
 #include <set>
 #include <vector>
 #include <string>
+#include <limits>
+#include <memory>
+#include <cstdint>
 #include <fstream>
 #include <utility>
+#include <memory_resource>
 #include <iostream>
 #include <unordered_set>
 
@@ -24,8 +29,18 @@ namespace CYK{
 /// Representation of a single replacement a variable can have
 using Replacement = std::vector<std::string>;
 
+class ParserContext;
+
+/// The variables in a cell of a Table, the cells of the table of a
+/// ParserContext allocate from its Arena
+using TableCell = std::pmr::set<std::string>;
+
 /// The datatype of the Table the CYK is using
-using Table = std::vector<std::vector<std::set<std::string>>>;
+using Table = std::vector<std::vector<TableCell>>;
+
+class Chart;
+class OutputSink;
+class BitsetParser;
 
 /// A struct that represents the productions of a CFG
 struct Productions {
@@ -42,20 +57,89 @@ struct Productions {
   /// Inverse of productions, mapping variables to replacements
   std::map<Replacement, std::set<std::string>> reverseProductions;
 
+  /**
+   * The weights of the productions
+   * Productions without an explicit weight have a weight of 1
+   */
+  std::map<std::pair<std::string, Replacement>, double> weights;
+
  public:
   /**
    * Add a production to productions
    * @param variable The variable of the production
    * @param replacement The replacement of the production
+   * @param weight The weight of the production, should be greater than 0
    */
-  void addProduction(const std::string &variable, const Replacement &replacement);
+  void addProduction(const std::string &variable,
+                     const Replacement &replacement,
+                     double weight = 1.0);
 
   /**
    * Get all the variables that have a certain replacement
    * @param replacement The replacement that the variable needs to have
    * @return A set of all the variables that have replacement replacement
    */
-  std::set<std::string> getVariablesThatProduce(const Replacement& replacement);
+  std::set<std::string> getVariablesThatProduce(
+      const Replacement& replacement) const;
+
+  /**
+   * Get all the variables that have a certain replacement without copying
+   * @param replacement The replacement that the variable needs to have
+   * @return The variables that have replacement replacement, nullptr if none,
+   *    valid as long as the productions are not changed
+   */
+  const std::set<std::string>* findVariablesThatProduce(
+      const Replacement& replacement) const;
+
+  /// @return All the productions, mapping every variable to its replacements
+  const std::map<std::string, std::set<Replacement>>& getProductions() const;
+
+  /**
+   * Get all the replacements a variable can have
+   * @param variable The variable whose replacements are requested
+   * @return A set of all the replacements of variable (empty if there are none)
+   */
+  const std::set<Replacement>& getReplacements(
+      const std::string& variable) const;
+
+  /**
+   * Get the weight of a production
+   * @param variable The variable of the production
+   * @param replacement The replacement of the production
+   * @return The weight of the production, 0 if there is no such production
+   */
+  double getWeight(const std::string& variable,
+                   const Replacement& replacement) const;
+};
+
+/// Settings that prune the weighted CYK table, trading exactness for speed
+struct Beam {
+  /// The maximum number of variables kept per cell, 0 means no limit
+  unsigned int width = 0;
+
+  /**
+   * Variables whose score is more than threshold below the score of the best
+   * variable in their cell are pruned, scores are natural logarithms
+   */
+  double threshold = std::numeric_limits<double>::infinity();
+};
+
+/// Statistics about the pruning done while filling a weighted CYK table
+struct BeamReport {
+  /// The number of variables that were kept in a cell
+  std::size_t kept = 0;
+
+  /// The number of variables that were removed from a cell
+  std::size_t pruned = 0;
+};
+
+/// A single derivation of an input together with its score
+struct Derivation {
+  /// The sum of the natural logarithms of the weights of the productions used
+  double score;
+
+  /// The parse tree in bracketed form e.g. "(S (A a) (B b))"
+  std::string tree;
 };
 
 /// A class representing the CFG with the addition of the CYK algorithm
@@ -74,26 +158,66 @@ class ContextFreeGrammar {
   std::unordered_set<std::string> terminals;
 
   /**
-   * Generates a table for the CYK table
-   * @param size The size the table should have
-   * @return A Table with the specified size
+   * Fills in the cells of a table with empty cells, diagonal by diagonal or
+   * for long inputs in tiles (see fillTile)
+   * @param table The table, its size is the length of input
+   * @param input The input string the table is for
+   * @param context The scratch space
    */
-  static Table generateCYKTable(int size);
+  void fill(Table& table, const std::string& input,
+            ParserContext& context) const;
 
   /**
-   * Get all the permutation of two sets
-   * @param set1 The first set that should be used for the permutation
-   * @param set2  The second set that should be used for the permutation
-   * @return A vector of vectors each containing two strings one from the first
-   *    set followed by one from the second
+   * Fills in the cells of a tile, a square of tile starts by tile ends
+   * The splits that only read tiles closer to the diagonal are applied a
+   * tile of split points at a time for all cells of the tile, so the cells
+   * they read are reused while they are in the cache. The other splits read
+   * shorter cells of the tile itself and are applied by length.
+   * @param table The table, the tiles closer to the diagonal need to be filled
+   * @param input The input string the table is for
+   * @param begin The first start of the tile
+   * @param end The first end of the tile (the last character of a substring)
+   * @param context The scratch space
    */
-  static std::vector<Replacement> getPermutations(
-      const std::set<std::string>& set1,
-      const std::set<std::string>& set2) ;
+  void fillTile(Table& table, const std::string& input, std::size_t begin,
+                std::size_t end, ParserContext& context) const;
 
-  /// Creates an HTML representation of the CYK table
-  static void createHTMLRepresentation(
-      const std::string& input, const Table& table) ;
+  /**
+   * Adds the variables of a single cell of the CYK table to a cell, see
+   * fillCell, so the cells of a table are filled in place
+   * @param context The scratch space
+   * @param cell The cell the variables are added to
+   */
+  void fillCell(const Table& table, const std::string& input, int i, int j,
+                ParserContext& context, TableCell& cell) const;
+
+  /**
+   * Adds the variables of some of the splits of a cell to the cell
+   * @param table The table, the cells the splits read need to be filled
+   * @param i The row of the cell
+   * @param j The column of the cell
+   * @param begin The first split, the length of the left substring minus one
+   * @param end The split after the last one
+   * @param context The scratch space
+   * @param cell The cell the variables are added to
+   */
+  void fillSplits(const Table& table, std::size_t i, std::size_t j,
+                  std::size_t begin, std::size_t end, ParserContext& context,
+                  TableCell& cell) const;
+
+  /// The number of starts and ends of a tile, 0 fills diagonal by diagonal
+  std::size_t tile;
+
+  /// Whether every variable fits into a std::string without allocating, see
+  /// ParserContext::getTable
+  bool shortVariables;
+
+  /// Identifies the CFG, see getFingerprint
+  std::uint64_t fingerprint;
+
+  /// Recognizes strings and fills in Charts without a Table, shared by the
+  /// copies of the CFG
+  std::shared_ptr<const BitsetParser> bitsetParser;
 
  public:
   /**
@@ -102,11 +226,146 @@ class ContextFreeGrammar {
    */
   explicit ContextFreeGrammar(const json &j);
 
+  /**
+   * Checks whether input is in th language of the CFG and creates an HTML
+   * representation of the CYK table in "CYKTable-<input>.html"
+   * @param input The input string that is being checked
+   * @return Whether input is in the language of the CFG
+   */
+  bool CYK(const std::string& input);
+
   /**
    * Checks whether input is in th language of the CFG
+   * A sink that only needs a Chart (OutputSink::usesChart) gets the one of
+   * the BitsetParser, no Table is built for it.
+   * @param input The input string that is being checked
+   * @param sink Receives the filled in CYK table
+   * @return Whether input is in the language of the CFG
+   */
+  bool CYK(const std::string& input, OutputSink& sink);
+
+  /**
+   * Checks whether input is in the language of the CFG without a Table
+   * The BitsetParser fills in the reused chart of the context, so the heap
+   * is not used once the buffers of the context are large enough.
    * @param input The input string that is being checked
+   * @param context The buffers that are used, by default the ones of the
+   *    calling thread (ParserContext::local)
+   * @return Whether input is in the language of the CFG
+   */
+  bool recognize(const std::string& input) const;
+  bool recognize(const std::string& input, ParserContext& context) const;
+
+  /**
+   * Checks whether a table accepts its input
+   * @param table A filled in table
+   * @return Whether the start symbol produces the whole input
+   */
+  bool accepts(const Table& table) const;
+
+  /**
+   * Generates a table for the CYK table
+   * @param size The size the table should have
+   * @return A Table with the specified size
+   */
+  static Table generateCYKTable(int size);
+
+  /**
+   * Fills in the CYK table for input
+   * @param input The input string the table is for
+   * @return The filled in table
+   */
+  Table fillTable(const std::string& input) const;
+
+  /**
+   * Fills in the CYK table for input in the reused table of a context
+   * @param input The input string the table is for
+   * @param context The context whose table is filled in
+   * @return The filled in table, valid until the context is used again
+   */
+  const Table& fillTable(const std::string& input,
+                         ParserContext& context) const;
+
+  /**
+   * Fills in the CYK table for input as a Chart, which answers whether a
+   * variable can produce a substring of input in constant time
+   * @param input The input string the chart is for
+   * @return The filled in chart with getVariables() as its variables
+   */
+  Chart createChart(const std::string& input) const;
+
+  /// @return The BitsetParser of the CFG, built with it
+  const BitsetParser& getBitsetParser() const;
+
+  /**
+   * Computes the variables of a single cell of the CYK table
+   * @param table The table, the cells of the rows below row i need to be filled
+   * @param input The input string the table is for
+   * @param i The row of the cell (the length of the substring minus one)
+   * @param j The column of the cell (the start of the substring)
+   * @return The variables that can produce input.substr(j, i+1)
+   */
+  TableCell fillCell(const Table& table, const std::string& input,
+                     int i, int j) const;
+
+  /// @return The size of the tiles, 0 if the table is filled by diagonal
+  std::size_t getTile() const;
+
+  /// @param tile The size of the tiles, 0 to fill the table by diagonal
+  void setTile(std::size_t tile);
+
+  /**
+   * Fills in the table of input once to warm up, then with every tile size
+   * from 16 to 256 and by diagonal, and keeps the fastest
+   * @param input A string as long as the ones that will be parsed, sizes
+   *    that are not smaller than half of it are not tried
+   * @return The tile size that was kept
+   */
+  std::size_t tune(const std::string& input);
+
+  /**
+   * Get the largest tile size (a power of two from 16 to 256) where the three
+   * tiles of a step (the tile and the left and right cells of its splits)
+   * fit in the L2 cache. The cache size is read once, 1 MiB if it is unknown.
+   * @return The tile size
+   */
+  static std::size_t defaultTile();
+
+  /// @return The start symbol of the CFG
+  const std::string& getStartSymbol() const;
+
+  /**
+   * Get a hash of everything that influences the tables of the CFG: the start
+   * symbol, the variables and the productions with their weights.
+   * CFGs with the same fingerprint accept the same strings and fill in the
+   * same tables.
+   * @return The fingerprint of the CFG
+   */
+  std::uint64_t getFingerprint() const;
+
+  /// @return The productions of the CFG
+  const Productions& getProductions() const;
+
+  /// @return The sorted variables of the CFG, including all production heads
+  std::vector<std::string> getVariables() const;
+
+  /**
+   * Finds the k best derivations of input using the weights of the productions
+   * The derivations are extracted lazily from a weighted CYK table so only
+   * the parts of the derivation forest that are needed are ever explored
+   * With a beam only the best variables of every cell are kept, which can
+   * miss derivations (or all of them) but is much faster for large grammars
+   * @param input The input string that is being parsed
+   * @param k The (maximum) number of derivations that should be returned
+   * @param beam The pruning that should be applied, by default none
+   * @param report If not null, is set to the statistics of the pruning
+   * @return The derivations of input from the start symbol ordered from best
+   *    to worst, empty if input is not in the language of the CFG
    */
-  void CYK(const std::string& input);
+  std::vector<Derivation> parse(const std::string& input,
+                                unsigned int k = 1,
+                                const Beam& beam = {},
+                                BeamReport* report = nullptr) const;
 };
 
 } // namespace CYK
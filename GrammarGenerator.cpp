@@ -0,0 +1,232 @@
+//============================================================================
+// Name        : GrammarGenerator.cpp
+// Author      : Tobias Wilfert
+//============================================================================
+
+#include "GrammarGenerator.h"
+
+#include <map>
+#include <set>
+#include <tuple>
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+/// The characters used as terminals, in order
+const std::string terminalNames =
+    "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+
+/// The productions of a CNF grammar by the index of their head
+struct Rules {
+  /// The variables, the index of the start symbol is start
+  std::vector<std::string> variables;
+  std::size_t start = 0;
+
+  /// The terminals each variable produces
+  std::vector<std::vector<std::string>> terminals;
+
+  /// The pairs of variables each variable produces
+  std::vector<std::vector<std::pair<std::size_t, std::size_t>>> binary;
+};
+
+/// Collects the CNF productions of a grammar
+Rules rulesOf(const CYK::ContextFreeGrammar& grammar) {
+  Rules rules;
+  rules.variables = grammar.getVariables();
+  std::map<std::string, std::size_t> index;
+  for(std::size_t v = 0; v < rules.variables.size(); ++v){
+    index[rules.variables[v]] = v;
+  }
+  rules.start = index.count(grammar.getStartSymbol()) ?
+                index[grammar.getStartSymbol()] : rules.variables.size();
+  rules.terminals.resize(rules.variables.size());
+  rules.binary.resize(rules.variables.size());
+  for(auto& production: grammar.getProductions().getProductions()){
+    const std::size_t head = index[production.first];
+    for(auto& body: production.second){
+      if(body.size() == 1 && body[0].size() == 1 && !index.count(body[0])){
+        rules.terminals[head].push_back(body[0]);
+      }else if(body.size() == 2 && index.count(body[0]) &&
+               index.count(body[1])){
+        rules.binary[head].emplace_back(index[body[0]], index[body[1]]);
+      }
+    }
+  }
+  return rules;
+}
+
+/**
+ * Get which variables can produce a string of which length
+ * @return derives[l][v] is whether variable v produces a string of length l
+ */
+std::vector<std::vector<char>> lengths(const Rules& rules, std::size_t length) {
+  const std::size_t count = rules.variables.size();
+  std::vector<std::vector<char>> derives(length + 1,
+                                         std::vector<char>(count, false));
+  for(std::size_t v = 0; v < count && length > 0; ++v){
+    derives[1][v] = !rules.terminals[v].empty();
+  }
+  for(std::size_t l = 2; l <= length; ++l){
+    for(std::size_t v = 0; v < count; ++v){
+      for(std::size_t r = 0; r < rules.binary[v].size() && !derives[l][v]; ++r){
+        const auto& rule = rules.binary[v][r];
+        for(std::size_t k = 1; k < l; ++k){
+          if(derives[k][rule.first] && derives[l-k][rule.second]){
+            derives[l][v] = true;
+            break;
+          }
+        }
+      }
+    }
+  }
+  return derives;
+}
+
+} // namespace
+
+CYK::GrammarGenerator::GrammarGenerator(std::uint64_t seed) : random(seed) {}
+
+std::size_t CYK::GrammarGenerator::below(std::size_t bound) {
+  return std::uniform_int_distribution<std::size_t>(0, bound - 1)(random);
+}
+
+json CYK::GrammarGenerator::grammar(const CYK::GrammarShape &shape) {
+  if(shape.variables == 0 || shape.terminals == 0 ||
+     shape.terminals > terminalNames.size()){
+    throw std::invalid_argument("A grammar needs at least one variable and "
+                                "between 1 and 62 terminals");
+  }
+  const std::size_t count = shape.variables;
+  if(shape.rules > count * count * count){
+    throw std::invalid_argument("More binary productions than possible");
+  }
+  std::vector<std::string> variables{"S"};
+  for(std::size_t v = 1; v < count; ++v){
+    variables.push_back("V" + std::to_string(v));
+  }
+
+  json j;
+  j["Start"] = "S";
+  j["Variables"] = variables;
+  j["Terminals"] = json::array();
+  j["Productions"] = json::array();
+  for(std::size_t t = 0; t < shape.terminals; ++t){
+    j["Terminals"].push_back(std::string{terminalNames[t]});
+  }
+
+  // Every terminal gets a variable and every variable a terminal
+  std::set<std::pair<std::size_t, std::size_t>> terminalRules;
+  for(std::size_t t = 0; t < shape.terminals; ++t){
+    terminalRules.emplace(t < count ? t : below(count), t);
+  }
+  for(std::size_t v = shape.terminals; v < count; ++v){
+    terminalRules.emplace(v, below(shape.terminals));
+  }
+  for(auto& rule: terminalRules){
+    j["Productions"].push_back(
+        {{"head", variables[rule.first]},
+         {"body", {std::string{terminalNames[rule.second]}}}});
+  }
+
+  std::set<std::tuple<std::size_t, std::size_t, std::size_t>> binary;
+  std::vector<std::pair<std::size_t, std::size_t>> bodies;
+  std::bernoulli_distribution reuse(shape.ambiguity);
+  while(binary.size() < shape.rules){
+    // The first production belongs to the start symbol
+    std::size_t head = binary.empty() ? 0 : below(count);
+    std::pair<std::size_t, std::size_t> body{below(count), below(count)};
+    if(!bodies.empty() && reuse(random)){
+      body = bodies[below(bodies.size())];
+    }
+    if(binary.emplace(head, body.first, body.second).second){
+      bodies.push_back(body);
+      j["Productions"].push_back(
+          {{"head", variables[head]},
+           {"body", {variables[body.first], variables[body.second]}}});
+    }
+  }
+  return j;
+}
+
+std::vector<std::string> CYK::GrammarGenerator::accepted(
+    const CYK::ContextFreeGrammar &grammar, std::size_t length,
+    std::size_t count) {
+  const Rules rules = rulesOf(grammar);
+  const auto derives = lengths(rules, length);
+  if(length == 0 || rules.start == rules.variables.size() ||
+     !derives[length][rules.start]){
+    throw std::invalid_argument("The grammar accepts no string of length " +
+                                std::to_string(length));
+  }
+
+  std::vector<std::string> strings;
+  std::vector<std::pair<std::size_t, std::size_t>> stack;
+  std::vector<std::pair<std::size_t, std::size_t>> choices;
+  while(strings.size() < count){
+    std::string input;
+    // Expand the leftmost variable first, (variable, length) pairs
+    stack.assign(1, {rules.start, length});
+    while(!stack.empty()){
+      const auto top = stack.back();
+      stack.pop_back();
+      if(top.second == 1){
+        const auto& terminals = rules.terminals[top.first];
+        input += terminals[below(terminals.size())];
+        continue;
+      }
+      // Every production and split that can produce the length is possible
+      choices.clear();
+      for(std::size_t r = 0; r < rules.binary[top.first].size(); ++r){
+        const auto& rule = rules.binary[top.first][r];
+        for(std::size_t k = 1; k < top.second; ++k){
+          if(derives[k][rule.first] && derives[top.second-k][rule.second]){
+            choices.emplace_back(r, k);
+          }
+        }
+      }
+      const auto choice = choices[below(choices.size())];
+      const auto& rule = rules.binary[top.first][choice.first];
+      stack.emplace_back(rule.second, top.second - choice.second);
+      stack.emplace_back(rule.first, choice.second);
+    }
+    strings.push_back(input);
+  }
+  return strings;
+}
+
+std::vector<std::string> CYK::GrammarGenerator::rejected(
+    const CYK::ContextFreeGrammar &grammar, std::size_t length,
+    std::size_t count, unsigned int attempts) {
+  const Rules rules = rulesOf(grammar);
+  std::vector<std::string> terminals;
+  for(auto& produced: rules.terminals){
+    terminals.insert(terminals.end(), produced.begin(), produced.end());
+  }
+  std::sort(terminals.begin(), terminals.end());
+  terminals.erase(std::unique(terminals.begin(), terminals.end()),
+                  terminals.end());
+  if(terminals.empty()){
+    throw std::invalid_argument("The grammar has no terminals");
+  }
+  // Only check the strings if the grammar accepts strings of this length
+  const auto derives = lengths(rules, length);
+  const bool check = length > 0 && rules.start < rules.variables.size() &&
+                     derives[length][rules.start];
+
+  std::vector<std::string> strings;
+  for(unsigned long tries = 0; strings.size() < count; ++tries){
+    if(tries >= static_cast<unsigned long>(attempts) * count){
+      throw std::invalid_argument("Could not find enough rejected strings of "
+                                  "length " + std::to_string(length));
+    }
+    std::string input;
+    for(std::size_t c = 0; c < length; ++c){
+      input += terminals[below(terminals.size())];
+    }
+    if(!check || !grammar.accepts(grammar.fillTable(input))){
+      strings.push_back(input);
+    }
+  }
+  return strings;
+}
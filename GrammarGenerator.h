@@ -0,0 +1,94 @@
+//============================================================================
+// Name        : GrammarGenerator.h
+// Author      : Tobias Wilfert
+//============================================================================
+
+#ifndef CYK__GRAMMARGENERATOR_H_
+#define CYK__GRAMMARGENERATOR_H_
+
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "ContextFreeGrammar.h"
+
+namespace CYK{
+
+/// The size and shape of a generated grammar
+struct GrammarShape {
+  /// The number of variables, including the start symbol "S"
+  unsigned int variables = 4;
+
+  /// The number of terminals, single characters (at most 62)
+  unsigned int terminals = 3;
+
+  /// The number of productions with two variables as their body
+  unsigned int rules = 8;
+
+  /**
+   * The fraction of binary productions that reuse the body of an earlier
+   * production with another head, 0 gives few and 1 many derivations per
+   * string
+   */
+  double ambiguity = 0;
+};
+
+/**
+ * Generates random grammars in Chomsky normal form and random strings that
+ * are or are not in their language, for benchmarks and stress tests
+ *
+ * The results only depend on the seed, so experiments can be repeated.
+ */
+class GrammarGenerator {
+ private:
+  /// The source of randomness
+  std::mt19937_64 random;
+
+  /// @return A uniformly distributed number in [0, bound)
+  std::size_t below(std::size_t bound);
+
+ public:
+  /// @param seed The seed of the random numbers
+  explicit GrammarGenerator(std::uint64_t seed = 42);
+
+  /**
+   * Generates a grammar in CNF
+   * Every variable has a production to a terminal, every terminal is produced
+   * by some variable and the start symbol has at least one binary production.
+   * @param shape The size and shape of the grammar
+   * @return The grammar in the format of Grammar.json
+   * @throws std::invalid_argument if the shape is impossible
+   */
+  json grammar(const GrammarShape& shape);
+
+  /**
+   * Generates strings in the language of a grammar by sampling derivations,
+   * every derivation of the requested length can be chosen
+   * @param grammar A grammar in CNF, productions that are not are ignored
+   * @param length The length of the strings
+   * @param count The number of strings
+   * @return The strings
+   * @throws std::invalid_argument if no string of that length is accepted
+   */
+  std::vector<std::string> accepted(const ContextFreeGrammar& grammar,
+                                    std::size_t length, std::size_t count);
+
+  /**
+   * Generates random strings over the terminals of a grammar that are not in
+   * its language, every string is checked with the CYK
+   * @param grammar A grammar in CNF
+   * @param length The length of the strings
+   * @param count The number of strings
+   * @param attempts The number of strings that are tried per string returned
+   * @return The strings
+   * @throws std::invalid_argument if not enough rejected strings were found
+   */
+  std::vector<std::string> rejected(const ContextFreeGrammar& grammar,
+                                    std::size_t length, std::size_t count,
+                                    unsigned int attempts = 1000);
+};
+
+} // namespace CYK
+
+#endif//CYK__GRAMMARGENERATOR_H_
@@ -0,0 +1,117 @@
+//============================================================================
+// Name        : GrammarRegistry.cpp
+// Author      : Tobias Wilfert
+//============================================================================
+
+#include "GrammarRegistry.h"
+
+#include <fstream>
+#include <stdexcept>
+
+CYK::GrammarRegistry::GrammarRegistry()
+    : versions(std::make_shared<const Versions>()) {}
+
+CYK::ContextFreeGrammar CYK::GrammarRegistry::read(
+    const std::string &path, std::filesystem::file_time_type &modified) {
+  std::error_code error;
+  modified = std::filesystem::last_write_time(path, error);
+  std::ifstream in(path);
+  if(!in){ throw std::runtime_error("Could not open " + path); }
+  try{
+    json j;
+    in >> j;
+    return ContextFreeGrammar{j};
+  }catch(const json::exception& e){
+    throw std::runtime_error("Could not parse " + path + ": " + e.what());
+  }
+}
+
+CYK::GrammarSnapshot CYK::GrammarRegistry::publish(
+    const std::string &name, const std::string &path,
+    std::filesystem::file_time_type modified,
+    const CYK::ContextFreeGrammar &grammar) {
+  std::shared_ptr<const Versions> current = std::atomic_load(&versions);
+  auto next = std::make_shared<Versions>(*current);
+  auto it = next->byName.find(name);
+  unsigned int version = it == next->byName.end() ? 1 : it->second->version + 1;
+  auto snapshot = std::make_shared<const GrammarVersion>(
+      GrammarVersion{name, version, path, modified, grammar});
+  next->byName[name] = snapshot;
+  if(next->defaultName.empty()){ next->defaultName = name; }
+  std::atomic_store(&versions, std::shared_ptr<const Versions>(std::move(next)));
+  return snapshot;
+}
+
+CYK::GrammarSnapshot CYK::GrammarRegistry::add(
+    const std::string &name, const CYK::ContextFreeGrammar &grammar) {
+  std::lock_guard<std::mutex> lock(writeMutex);
+  return publish(name, "", {}, grammar);
+}
+
+CYK::GrammarSnapshot CYK::GrammarRegistry::load(const std::string &name,
+                                                const std::string &path) {
+  // Parse before taking the lock, other writers do not have to wait for it
+  std::filesystem::file_time_type modified;
+  ContextFreeGrammar grammar = read(path, modified);
+  std::lock_guard<std::mutex> lock(writeMutex);
+  return publish(name, path, modified, grammar);
+}
+
+std::vector<CYK::GrammarSnapshot> CYK::GrammarRegistry::reload(
+    bool all, std::vector<std::string> *errors) {
+  std::vector<GrammarSnapshot> reloaded;
+  for(auto& old: getAll()){
+    if(old->path.empty()){ continue; }
+    std::error_code error;
+    auto modified = std::filesystem::last_write_time(old->path, error);
+    if(!all && !error){
+      std::lock_guard<std::mutex> lock(writeMutex);
+      auto it = failed.find(old->path);
+      if(modified == old->modified ||
+         (it != failed.end() && it->second == modified)){
+        continue;
+      }
+    }
+    try{
+      ContextFreeGrammar grammar = read(old->path, modified);
+      std::lock_guard<std::mutex> lock(writeMutex);
+      failed.erase(old->path);
+      // Skip it if the grammar was replaced or removed in the meantime
+      GrammarSnapshot current = get(old->name);
+      if(current != old){ continue; }
+      reloaded.push_back(publish(old->name, old->path, modified, grammar));
+    }catch(const std::exception& e){
+      std::lock_guard<std::mutex> lock(writeMutex);
+      failed[old->path] = modified;
+      if(errors){ errors->emplace_back(e.what()); }
+    }
+  }
+  return reloaded;
+}
+
+bool CYK::GrammarRegistry::remove(const std::string &name) {
+  std::lock_guard<std::mutex> lock(writeMutex);
+  std::shared_ptr<const Versions> current = std::atomic_load(&versions);
+  if(!current->byName.count(name)){ return false; }
+  auto next = std::make_shared<Versions>(*current);
+  next->byName.erase(name);
+  if(next->defaultName == name){
+    next->defaultName = next->byName.empty() ? ""
+                                             : next->byName.begin()->first;
+  }
+  std::atomic_store(&versions, std::shared_ptr<const Versions>(std::move(next)));
+  return true;
+}
+
+CYK::GrammarSnapshot CYK::GrammarRegistry::get(const std::string &name) const {
+  std::shared_ptr<const Versions> current = std::atomic_load(&versions);
+  auto it = current->byName.find(name.empty() ? current->defaultName : name);
+  return it == current->byName.end() ? nullptr : it->second;
+}
+
+std::vector<CYK::GrammarSnapshot> CYK::GrammarRegistry::getAll() const {
+  std::shared_ptr<const Versions> current = std::atomic_load(&versions);
+  std::vector<GrammarSnapshot> all;
+  for(auto& entry: current->byName){ all.push_back(entry.second); }
+  return all;
+}
@@ -0,0 +1,146 @@
+//============================================================================
+// Name        : GrammarRegistry.h
+// Author      : Tobias Wilfert
+//============================================================================
+
+#ifndef CYK__GRAMMARREGISTRY_H_
+#define CYK__GRAMMARREGISTRY_H_
+
+#include <map>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <vector>
+#include <filesystem>
+
+#include "ContextFreeGrammar.h"
+
+namespace CYK{
+
+/// A version of a named grammar
+struct GrammarVersion {
+  /// The name of the grammar
+  std::string name;
+
+  /// The version, the first version of a name is 1
+  unsigned int version;
+
+  /// The file the grammar was loaded from, empty if it was added directly
+  std::string path;
+
+  /// The time the file was last modified when it was loaded
+  std::filesystem::file_time_type modified;
+
+  /// The grammar
+  ContextFreeGrammar grammar;
+};
+
+/// A version of a grammar that stays valid as long as it is held
+using GrammarSnapshot = std::shared_ptr<const GrammarVersion>;
+
+/**
+ * Holds the current version of several named grammars
+ *
+ * Readers get a snapshot of a grammar and can keep using it for as long as
+ * they need, even after a newer version was added. The names are kept in an
+ * immutable map that is replaced as a whole (with std::atomic_load and
+ * std::atomic_store) whenever a grammar is added, reloaded or removed, so
+ * getting a grammar never waits for a reload. Writers are serialized, a new
+ * version is parsed before the map is replaced.
+ */
+class GrammarRegistry {
+ private:
+  /// The state that is replaced as a whole
+  struct Versions {
+    /// The current versions by name
+    std::map<std::string, GrammarSnapshot> byName;
+
+    /// The name of the grammar used when none is given
+    std::string defaultName;
+  };
+
+  /// The current versions, only accessed with std::atomic_load/atomic_store
+  std::shared_ptr<const Versions> versions;
+
+  /// Serializes the writers
+  std::mutex writeMutex;
+
+  /// The files that could not be read by reload, with the time they were
+  /// last modified then, they are only read again once they change
+  std::map<std::string, std::filesystem::file_time_type> failed;
+
+  /**
+   * Replaces the current version of a grammar, writeMutex needs to be held
+   * @param name The name of the grammar
+   * @param path The file the grammar was loaded from
+   * @param modified The time the file was last modified
+   * @param grammar The new version of the grammar
+   * @return The new version
+   */
+  GrammarSnapshot publish(const std::string& name, const std::string& path,
+                          std::filesystem::file_time_type modified,
+                          const ContextFreeGrammar& grammar);
+
+  /**
+   * Reads a grammar from a JSON file
+   * @param path The file
+   * @param modified Is set to the time the file was last modified
+   * @return The grammar
+   * @throws std::runtime_error if the file can not be read or parsed
+   */
+  static ContextFreeGrammar read(const std::string& path,
+                                 std::filesystem::file_time_type& modified);
+
+ public:
+  GrammarRegistry();
+
+  /**
+   * Adds a new version of a grammar, the first grammar added is the default
+   * @param name The name of the grammar
+   * @param grammar The grammar
+   * @return The new version
+   */
+  GrammarSnapshot add(const std::string& name,
+                      const ContextFreeGrammar& grammar);
+
+  /**
+   * Adds a new version of a grammar read from a JSON file, which is used
+   * again by reload
+   * @param name The name of the grammar
+   * @param path The file
+   * @return The new version
+   * @throws std::runtime_error if the file can not be read or parsed
+   */
+  GrammarSnapshot load(const std::string& name, const std::string& path);
+
+  /**
+   * Reads the grammars that were loaded from a file again
+   * A grammar whose file can not be read or parsed keeps its current version
+   * @param all Whether grammars whose file did not change are read as well
+   * @param errors Receives a message for every file that could not be read
+   * @return The new versions
+   */
+  std::vector<GrammarSnapshot> reload(
+      bool all, std::vector<std::string>* errors = nullptr);
+
+  /**
+   * Removes a grammar, snapshots of it stay valid
+   * @param name The name of the grammar
+   * @return Whether there was a grammar with that name
+   */
+  bool remove(const std::string& name);
+
+  /**
+   * Get the current version of a grammar
+   * @param name The name of the grammar, empty for the default grammar
+   * @return The current version or nullptr if there is no such grammar
+   */
+  GrammarSnapshot get(const std::string& name) const;
+
+  /// @return The current version of every grammar
+  std::vector<GrammarSnapshot> getAll() const;
+};
+
+} // namespace CYK
+
+#endif//CYK__GRAMMARREGISTRY_H_
@@ -0,0 +1,209 @@
+//============================================================================
+// Name        : HTMLWriter.cpp
+// Author      : Tobias Wilfert
+//============================================================================
+
+#include "HTMLWriter.h"
+
+#include <map>
+#include <cstdio>
+#include <algorithm>
+#include <functional>
+
+CYK::HTMLWriter::HTMLWriter(std::ostream &out) : writer(out) {}
+
+void CYK::HTMLWriter::writeHeader() {
+  writer.write("<html lang=\"en\" >\n"
+               "<style>\n"
+               "  table, td { border: 1px solid black;\n"
+               "              padding: 5px;}\n"
+               "  html *{font-family: Arial, Helvetica, sans-serif;}\n"
+               "</style>\n"
+               "<table>\n");
+}
+
+void CYK::HTMLWriter::writeCell(const CYK::TableCell &variables) {
+  writer.write("    <td>");
+  bool first = true;
+  for(auto& con: variables){
+    if(!first){ writer.write(','); }
+    writer.write(con);
+    first = false;
+  }
+  writer.write("</td>\n");
+}
+
+void CYK::HTMLWriter::write(const std::string &input, const CYK::Table &table) {
+  writeWindow(input, table, 0, input.size());
+}
+
+void CYK::HTMLWriter::write(const std::string &input, const CYK::Table &table,
+                            const CYK::HTMLView &view,
+                            const CYK::ContextFreeGrammar *grammar) {
+  switch(view.mode){
+    case HTMLView::Mode::Full:
+      writeWindow(input, table, 0, input.size());
+      break;
+    case HTMLView::Mode::Window: {
+      std::size_t end = std::min(view.end, input.size());
+      writeWindow(input, table, std::min(view.begin, end), end);
+      break;
+    }
+    case HTMLView::Mode::Heatmap:
+      writeHeatmap(input, table, std::max<std::size_t>(view.resolution, 1));
+      break;
+    case HTMLView::Mode::Derivation:
+      if(grammar){
+        writeDerivation(input, table, *grammar);
+      }else{
+        writeWindow(input, table, 0, input.size());
+      }
+      break;
+  }
+}
+
+void CYK::HTMLWriter::writeWindow(const std::string &input,
+                                  const CYK::Table &table, std::size_t begin,
+                                  std::size_t end) {
+  writeHeader();
+  writer.write("<caption>CYK table for \"");
+  writer.write(input.data() + begin, end - begin);
+  writer.write('"');
+  if(end - begin != input.size()){
+    writer.write(" (characters ");
+    writer.write(static_cast<unsigned long long>(begin));
+    writer.write(" to ");
+    writer.write(static_cast<unsigned long long>(end));
+    writer.write(" of ");
+    writer.write(static_cast<unsigned long long>(input.size()));
+    writer.write(')');
+  }
+  writer.write("</caption>\n");
+  // The Main table, only the substrings that lie within the window
+  for(std::size_t i = end - begin; i-- > 0;){
+    writer.write("  <tr>\n");
+    for(std::size_t j = begin; j + i < end; ++j){
+      writeCell(table[i][j]);
+    }
+    writer.write("  </tr>\n");
+  }
+  // Add the input to the bottom of the table
+  writer.write("  <tr>\n");
+  for(std::size_t j = begin; j < end; ++j){
+    writer.write("    <th>");
+    writer.write(input[j]);
+    writer.write("</th>\n");
+  }
+  writer.write("  </tr>\n"
+               "</table>\n"
+               "</html>");
+  writer.flush();
+}
+
+void CYK::HTMLWriter::writeHeatmap(const std::string &input,
+                                   const CYK::Table &table,
+                                   std::size_t resolution) {
+  const std::size_t size = table.size();
+  const std::size_t block = std::max<std::size_t>(
+      (size + resolution - 1) / resolution, 1);
+  const std::size_t blocks = (size + block - 1) / block;
+  // The number of cells and of non-empty cells of every block
+  std::vector<std::size_t> cells(blocks * blocks), occupied(blocks * blocks);
+  for(std::size_t i = 0; i < size; ++i){
+    for(std::size_t j = 0; j < table[i].size(); ++j){
+      std::size_t index = i / block * blocks + j / block;
+      ++cells[index];
+      if(!table[i][j].empty()){ ++occupied[index]; }
+    }
+  }
+
+  writeHeader();
+  writer.write("<caption>Occupancy of the CYK table for a string of ");
+  writer.write(static_cast<unsigned long long>(input.size()));
+  writer.write(" characters, every cell covers ");
+  writer.write(static_cast<unsigned long long>(block));
+  writer.write(" x ");
+  writer.write(static_cast<unsigned long long>(block));
+  writer.write(" cells</caption>\n");
+  for(std::size_t row = blocks; row-- > 0;){
+    writer.write("  <tr>\n");
+    for(std::size_t col = 0; col < blocks; ++col){
+      std::size_t index = row * blocks + col;
+      if(cells[index] == 0){ continue; }
+      const unsigned long long percent = occupied[index] * 100 / cells[index];
+      char opacity[8];
+      std::snprintf(opacity, sizeof(opacity), "%.2f", percent / 100.0);
+      writer.write("    <td style=\"background: rgba(0, 0, 255, ");
+      writer.write(opacity);
+      writer.write(")\" title=\"lengths ");
+      writer.write(static_cast<unsigned long long>(row * block + 1));
+      writer.write('-');
+      writer.write(static_cast<unsigned long long>(
+          std::min(size, (row + 1) * block)));
+      writer.write(", starts ");
+      writer.write(static_cast<unsigned long long>(col * block));
+      writer.write('-');
+      writer.write(static_cast<unsigned long long>(
+          std::min(size, (col + 1) * block) - 1));
+      writer.write("\">");
+      writer.write(percent);
+      writer.write("%</td>\n");
+    }
+    writer.write("  </tr>\n");
+  }
+  writer.write("</table>\n"
+               "</html>");
+  writer.flush();
+}
+
+void CYK::HTMLWriter::writeDerivation(const std::string &input,
+                                      const CYK::Table &table,
+                                      const CYK::ContextFreeGrammar &grammar) {
+  // The variables of every cell that are reachable from the start symbol,
+  // ordered such that longer substrings come first
+  using Cell = std::pair<std::size_t, std::size_t>;
+  std::map<Cell, TableCell, std::greater<Cell>> useful;
+  if(grammar.accepts(table)){
+    useful[{table.size() - 1, 0}].insert(grammar.getStartSymbol());
+  }
+  const Productions& productions = grammar.getProductions();
+  // Children always have a shorter substring, so they are visited later on
+  for(auto& entry: useful){
+    const std::size_t i = entry.first.first, j = entry.first.second;
+    for(auto& var: entry.second){
+      for(auto& rep: productions.getReplacements(var)){
+        if(rep.size() != 2){ continue; }
+        for(std::size_t k = 0; k < i; ++k){ // Looking at (k,j) (i-k-1,j+k+1)
+          if(table[k][j].count(rep[0]) && table[i-k-1][j+k+1].count(rep[1])){
+            useful[{k, j}].insert(rep[0]);
+            useful[{i-k-1, j+k+1}].insert(rep[1]);
+          }
+        }
+      }
+    }
+  }
+
+  writeHeader();
+  writer.write("<caption>Cells of the derivations of \"");
+  writer.write(grammar.getStartSymbol());
+  writer.write("\" for a string of ");
+  writer.write(static_cast<unsigned long long>(input.size()));
+  writer.write(" characters</caption>\n"
+               "  <tr>\n"
+               "    <th>Substring</th>\n"
+               "    <th>Variables</th>\n"
+               "  </tr>\n");
+  for(auto& entry: useful){
+    writer.write("  <tr>\n    <td>[");
+    writer.write(static_cast<unsigned long long>(entry.first.second));
+    writer.write(", ");
+    writer.write(static_cast<unsigned long long>(
+        entry.first.second + entry.first.first + 1));
+    writer.write(")</td>\n");
+    writeCell(entry.second);
+    writer.write("  </tr>\n");
+  }
+  writer.write("</table>\n"
+               "</html>");
+  writer.flush();
+}
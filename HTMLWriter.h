@@ -0,0 +1,101 @@
+//============================================================================
+// Name        : HTMLWriter.h
+// Author      : Tobias Wilfert
+//============================================================================
+
+#ifndef CYK__HTMLWRITER_H_
+#define CYK__HTMLWRITER_H_
+
+#include <string>
+#include <ostream>
+
+#include "BufferedWriter.h"
+#include "ContextFreeGrammar.h"
+
+namespace CYK{
+
+/// Which part of a table an HTML representation shows
+struct HTMLView {
+  /// The kinds of representations
+  enum class Mode {
+    /// Every cell of the table
+    Full,
+    /// Only the cells of the substrings of input[begin, end)
+    Window,
+    /// A down-sampled grid showing which fraction of the cells is not empty
+    Heatmap,
+    /// Only the variables that are part of a derivation of the start symbol
+    Derivation
+  };
+
+  /// The kind of representation
+  Mode mode = Mode::Full;
+
+  /// The first character of the window
+  std::size_t begin = 0;
+
+  /// The character after the window, clamped to the length of the input
+  std::size_t end = std::string::npos;
+
+  /// The maximum number of rows (and columns) of the heatmap
+  std::size_t resolution = 64;
+};
+
+/**
+ * Writes the HTML representation of a CYK table
+ *
+ * The document is streamed row by row through a fixed-size buffer, so the
+ * memory needed does not depend on the size of the table. For tables that
+ * are too large to look at as a whole an HTMLView selects a summary.
+ */
+class HTMLWriter {
+ private:
+  /// The buffered output
+  BufferedWriter writer;
+
+  /// Writes everything up to and including the opening tag of the table
+  void writeHeader();
+
+  /// Writes a cell with the variables of a set separated by commas
+  void writeCell(const TableCell& variables);
+
+  /// Writes the table of a window of the input
+  void writeWindow(const std::string& input, const Table& table,
+                   std::size_t begin, std::size_t end);
+
+  /// Writes the down-sampled occupancy of the table
+  void writeHeatmap(const std::string& input, const Table& table,
+                    std::size_t resolution);
+
+  /// Writes the variables that take part in a derivation of the start symbol
+  void writeDerivation(const std::string& input, const Table& table,
+                       const ContextFreeGrammar& grammar);
+
+ public:
+  /**
+   * Creates a writer
+   * @param out The stream the HTML is written to
+   */
+  explicit HTMLWriter(std::ostream& out);
+
+  /**
+   * Writes the HTML representation of a table
+   * @param input The input string of the table
+   * @param table The filled in table
+   */
+  void write(const std::string& input, const Table& table);
+
+  /**
+   * Writes (a summary of) the HTML representation of a table
+   * @param input The input string of the table
+   * @param table The filled in table
+   * @param view Which part of the table should be shown
+   * @param grammar The CFG of the table, needed for HTMLView::Mode::Derivation
+   */
+  void write(const std::string& input, const Table& table,
+             const HTMLView& view, const ContextFreeGrammar* grammar);
+};
+
+} // namespace CYK
+
+#endif//CYK__HTMLWRITER_H_
@@ -0,0 +1,27 @@
+//============================================================================
+// Name        : Hash.cpp
+// Author      : Tobias Wilfert
+//============================================================================
+
+#include "Hash.h"
+
+std::uint64_t CYK::hash(const void *data, std::size_t length,
+                        std::uint64_t seed) {
+  const auto* bytes = static_cast<const unsigned char*>(data);
+  for(std::size_t i = 0; i < length; ++i){
+    seed ^= bytes[i];
+    seed *= 0x100000001b3ULL;
+  }
+  return seed;
+}
+
+std::uint64_t CYK::hash(const std::string &text, std::uint64_t seed) {
+  return hash(text.data(), text.size(), seed);
+}
+
+std::string CYK::toHex(std::uint64_t value) {
+  static const char digits[] = "0123456789abcdef";
+  std::string result(16, '0');
+  for(std::size_t i = 16; i-- > 0; value >>= 4){ result[i] = digits[value & 0xf]; }
+  return result;
+}
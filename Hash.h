@@ -0,0 +1,35 @@
+//============================================================================
+// Name        : Hash.h
+// Author      : Tobias Wilfert
+//============================================================================
+
+#ifndef CYK__HASH_H_
+#define CYK__HASH_H_
+
+#include <string>
+#include <cstdint>
+
+namespace CYK{
+
+/// The offset basis of the 64-bit FNV-1a hash
+constexpr std::uint64_t hashSeed = 0xcbf29ce484222325ULL;
+
+/**
+ * Hashes bytes with the 64-bit FNV-1a hash
+ * @param data The first byte
+ * @param length The number of bytes
+ * @param seed The hash to continue from, allows hashing several pieces
+ * @return The hash
+ */
+std::uint64_t hash(const void* data, std::size_t length,
+                   std::uint64_t seed = hashSeed);
+
+/// @return The 64-bit FNV-1a hash of text
+std::uint64_t hash(const std::string& text, std::uint64_t seed = hashSeed);
+
+/// @return value as 16 lowercase hexadecimal digits
+std::string toHex(std::uint64_t value);
+
+} // namespace CYK
+
+#endif//CYK__HASH_H_
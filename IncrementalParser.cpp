@@ -0,0 +1,73 @@
+//============================================================================
+// Name        : IncrementalParser.cpp
+// Author      : Tobias Wilfert
+//============================================================================
+
+#include "IncrementalParser.h"
+
+#include <algorithm>
+
+CYK::IncrementalParser::IncrementalParser(const ContextFreeGrammar &grammar,
+                                          std::string input)
+    : grammar(grammar) {
+  edit(0, 0, input);
+}
+
+bool CYK::IncrementalParser::edit(std::size_t position, std::size_t length,
+                                  const std::string &replacement) {
+  // std::string::replace validates position and clamps length for us
+  const std::size_t oldSize = input.size();
+  input.replace(position, length, replacement);
+  length = std::min(length, oldSize - position);
+
+  const int size = input.size();
+  const int editEnd = position + replacement.size();
+  const int shift = static_cast<int>(replacement.size()) -
+      static_cast<int>(length);
+  Table old = std::move(table);
+  table.clear();
+  recomputed = 0;
+
+  for(int i = 0; i < size; ++i){
+    table.emplace_back(size - i);
+    for(int j = 0; j < size - i; ++j){ // Looking at (i,j)
+      const int end = j + i + 1;
+      if(end <= static_cast<int>(position)){
+        // Entirely before the edit, same place in the old table
+        table[i][j] = std::move(old[i][j]);
+      }else if(j >= editEnd){
+        // Entirely after the edit, shifted in the old table
+        table[i][j] = std::move(old[i][j - shift]);
+      }else{
+        table[i][j] = grammar.fillCell(table, input, i, j);
+        ++recomputed;
+      }
+    }
+  }
+  return accepts();
+}
+
+bool CYK::IncrementalParser::insert(std::size_t position,
+                                    const std::string &text) {
+  return edit(position, 0, text);
+}
+
+bool CYK::IncrementalParser::erase(std::size_t position, std::size_t length) {
+  return edit(position, length, "");
+}
+
+bool CYK::IncrementalParser::accepts() const {
+  return grammar.accepts(table);
+}
+
+const std::string &CYK::IncrementalParser::getInput() const {
+  return input;
+}
+
+const CYK::Table &CYK::IncrementalParser::getTable() const {
+  return table;
+}
+
+std::size_t CYK::IncrementalParser::getRecomputed() const {
+  return recomputed;
+}
@@ -0,0 +1,86 @@
+//============================================================================
+// Name        : IncrementalParser.h
+// Author      : Tobias Wilfert
+//============================================================================
+
+#ifndef CYK__INCREMENTALPARSER_H_
+#define CYK__INCREMENTALPARSER_H_
+
+#include <string>
+
+#include "ContextFreeGrammar.h"
+
+namespace CYK{
+
+/**
+ * A CYK table that is kept up to date while its input is being edited
+ *
+ * After an edit only the cells whose substring overlaps the edited region are
+ * recomputed, the cells entirely before or after it are reused (the latter
+ * shifted by the change in length).
+ */
+class IncrementalParser {
+ private:
+  /// The CFG the input is checked against
+  const ContextFreeGrammar& grammar;
+
+  /// The current input
+  std::string input;
+
+  /// The CYK table of the current input
+  Table table;
+
+  /// The number of cells computed by the last edit (or the initial fill)
+  std::size_t recomputed = 0;
+
+ public:
+  /**
+   * Fills in the CYK table for input
+   * @param grammar The CFG, needs to outlive the parser
+   * @param input The initial input
+   */
+  IncrementalParser(const ContextFreeGrammar& grammar, std::string input);
+
+  /**
+   * Replaces part of the input and updates the table
+   * @param position The position of the first character that is replaced
+   * @param length The number of characters that are replaced
+   * @param replacement The characters that replace them
+   * @return Whether the edited input is in the language of the CFG
+   * @throws std::out_of_range If position is past the end of the input
+   */
+  bool edit(std::size_t position, std::size_t length,
+            const std::string& replacement);
+
+  /**
+   * Inserts characters into the input and updates the table
+   * @param position The position the characters are inserted at
+   * @param text The characters that are inserted
+   * @return Whether the edited input is in the language of the CFG
+   */
+  bool insert(std::size_t position, const std::string& text);
+
+  /**
+   * Removes characters from the input and updates the table
+   * @param position The position of the first character that is removed
+   * @param length The number of characters that are removed
+   * @return Whether the edited input is in the language of the CFG
+   */
+  bool erase(std::size_t position, std::size_t length);
+
+  /// @return Whether the current input is in the language of the CFG
+  bool accepts() const;
+
+  /// @return The current input
+  const std::string& getInput() const;
+
+  /// @return The CYK table of the current input
+  const Table& getTable() const;
+
+  /// @return The number of cells that were computed by the last edit
+  std::size_t getRecomputed() const;
+};
+
+} // namespace CYK
+
+#endif//CYK__INCREMENTALPARSER_H_
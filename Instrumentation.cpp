@@ -0,0 +1,36 @@
+//============================================================================
+// Name        : Instrumentation.cpp
+// Author      : Tobias Wilfert
+//============================================================================
+
+#include "Instrumentation.h"
+
+#include <numeric>
+
+json CYK::ParseProfile::toJson() const {
+  json j;
+  j["length"] = length;
+  j["fill_ns"] = std::accumulate(diagonals.begin(), diagonals.end(),
+                                 std::uint64_t{0});
+  j["first_row_ns"] = firstRow;
+  j["diagonal_ns"] = diagonals;
+  j["rule_lookup_ns"] = ruleLookups;
+  j["set_union_ns"] = setUnions;
+  j["output_ns"] = output;
+  j["splits"] = splits;
+  j["candidate_pairs"] = candidatePairs;
+  j["rule_hits"] = ruleHits;
+  return j;
+}
+
+CYK::ParseProfile &CYK::Instrumentation::current() {
+  thread_local ParseProfile profile;
+  return profile;
+}
+
+void CYK::Instrumentation::start(std::size_t length) {
+  ParseProfile& profile = current();
+  profile = ParseProfile{};
+  profile.length = length;
+  profile.diagonals.assign(length, 0);
+}
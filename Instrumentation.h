@@ -0,0 +1,126 @@
+//============================================================================
+// Name        : Instrumentation.h
+// Author      : Tobias Wilfert
+//============================================================================
+
+#ifndef CYK__INSTRUMENTATION_H_
+#define CYK__INSTRUMENTATION_H_
+
+#include <chrono>
+#include <vector>
+#include <cstdint>
+
+#include "nlohmann/json.hpp"
+using json = nlohmann::json;
+
+namespace CYK{
+
+/**
+ * Where the time of filling in a CYK table went, all times are in nanoseconds
+ * The rule lookups and set unions are part of the diagonals they happen in.
+ */
+struct ParseProfile {
+  /// The length of the input
+  std::size_t length = 0;
+
+  /// Filling in the cells of the single characters
+  std::uint64_t firstRow = 0;
+
+  /// Filling in every row of the table, diagonals[i] is the row of the
+  /// substrings of length i+1 (diagonals[0] is the first row). A table that
+  /// is filled in tiles has all rows after the first one in diagonals[1].
+  std::vector<std::uint64_t> diagonals;
+
+  /// Looking up the variables that produce a pair of variables
+  std::uint64_t ruleLookups = 0;
+
+  /// Adding the variables that were found to their cell
+  std::uint64_t setUnions = 0;
+
+  /// Writing the filled in table to its sink
+  std::uint64_t output = 0;
+
+  /// The number of (cell, split) pairs that were looked at
+  std::uint64_t splits = 0;
+
+  /// The number of pairs of variables that were looked up
+  std::uint64_t candidatePairs = 0;
+
+  /// The number of looked up pairs that were produced by some variable
+  std::uint64_t ruleHits = 0;
+
+  /// @return The profile as a JSON object
+  json toJson() const;
+};
+
+/**
+ * Per phase timers and operation counters of the CYK
+ *
+ * They are only recorded when the library is built with CYK_INSTRUMENTATION
+ * (cmake -DCYK_INSTRUMENTATION=ON), otherwise the macros below expand to
+ * nothing and the hot loops are exactly as without them. Every thread has
+ * its own profile, which is started again by every fillTable.
+ */
+namespace Instrumentation{
+
+#ifdef CYK_INSTRUMENTATION
+/// Whether the instrumentation is compiled in
+constexpr bool enabled = true;
+#else
+/// Whether the instrumentation is compiled in
+constexpr bool enabled = false;
+#endif
+
+/// @return The profile of the current thread
+ParseProfile& current();
+
+/**
+ * Starts a new profile on the current thread
+ * @param length The length of the input
+ */
+void start(std::size_t length);
+
+/// Adds the time from its creation to its destruction to a profile field
+class Timer {
+ private:
+  /// The field the time is added to
+  std::uint64_t& target;
+
+  /// When the timer was created
+  std::chrono::steady_clock::time_point begin;
+
+ public:
+  /// @param target The field the time is added to
+  explicit Timer(std::uint64_t& target)
+      : target(target), begin(std::chrono::steady_clock::now()) {}
+
+  Timer(const Timer&) = delete;
+  Timer& operator=(const Timer&) = delete;
+
+  ~Timer() {
+    target += std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - begin).count();
+  }
+};
+
+} // namespace Instrumentation
+
+} // namespace CYK
+
+#ifdef CYK_INSTRUMENTATION
+/// Times the rest of the enclosing scope into a field of the current profile
+#define CYK_PROFILE_TIME(field) \
+  CYK::Instrumentation::Timer cykProfileTimer{ \
+      CYK::Instrumentation::current().field}
+/// Adds to a counter of the current profile
+#define CYK_PROFILE_COUNT(field, n) \
+  (CYK::Instrumentation::current().field += (n))
+/// Starts a new profile on the current thread
+#define CYK_PROFILE_START(length) CYK::Instrumentation::start(length)
+#else
+#define CYK_PROFILE_TIME(field) ((void)0)
+#define CYK_PROFILE_COUNT(field, n) ((void)0)
+#define CYK_PROFILE_START(length) ((void)0)
+#endif
+
+#endif//CYK__INSTRUMENTATION_H_
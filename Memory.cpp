@@ -0,0 +1,164 @@
+//============================================================================
+// Name        : Memory.cpp
+// Author      : Tobias Wilfert
+//============================================================================
+
+#include "Memory.h"
+
+#include "BitsetParser.h"
+
+namespace {
+
+/// @return The bytes of a heap allocation of a number of bytes
+std::size_t allocation(std::size_t bytes) {
+  return bytes == 0 ? 0 : bytes + 2 * sizeof(void*);
+}
+
+/// @return The bytes of a node of a tree or hash container holding a value
+std::size_t node(std::size_t value) {
+  return allocation(4 * sizeof(void*) + value);
+}
+
+/// @return The bytes a string has on the heap, 0 if it fits in the string
+std::size_t heap(const std::string& string) {
+  const char* data = string.data();
+  const char* object = reinterpret_cast<const char*>(&string);
+  if(data >= object && data < object + sizeof(string)){ return 0; }
+  return allocation(string.capacity() + 1);
+}
+
+/// @return The bytes a copy of a string of a certain length has on the heap
+std::size_t heapOfCopy(std::size_t length) {
+  static const std::size_t inline_ = std::string().capacity();
+  return length <= inline_ ? 0 : allocation(length + 1);
+}
+
+/// @return The bytes a replacement has on the heap
+std::size_t heap(const CYK::Replacement& replacement) {
+  std::size_t bytes = allocation(replacement.capacity() * sizeof(std::string));
+  for(auto& symbol: replacement){ bytes += heap(symbol); }
+  return bytes;
+}
+
+/// @return The bytes of a set of variables
+std::size_t bytesOf(const CYK::TableCell& cell) {
+  std::size_t bytes = cell.size() * node(sizeof(std::string));
+  for(auto& variable: cell){ bytes += heap(variable); }
+  return bytes;
+}
+
+} // namespace
+
+std::size_t CYK::Memory::bytesOf(const CYK::Table &table) {
+  std::size_t bytes = sizeof(Table) +
+                      allocation(table.capacity() * sizeof(table[0]));
+  for(auto& row: table){
+    bytes += allocation(row.capacity() * sizeof(row[0]));
+    for(auto& cell: row){ bytes += ::bytesOf(cell); }
+  }
+  return bytes;
+}
+
+std::size_t CYK::Memory::bytesOf(const CYK::Chart &chart) {
+  std::size_t bytes = sizeof(Chart) +
+      allocation(chart.getCells().capacity() * sizeof(std::uint64_t)) +
+      allocation(chart.getSymbols().capacity() * sizeof(std::string));
+  for(auto& symbol: chart.getSymbols()){
+    // The symbol and its copy in the index
+    bytes += 2 * heap(symbol) + node(sizeof(std::string) + sizeof(std::size_t));
+  }
+  return bytes + allocation(chart.getSymbols().size() * sizeof(void*));
+}
+
+std::size_t CYK::Memory::bytesOf(const CYK::ContextFreeGrammar &grammar) {
+  std::size_t bytes = sizeof(ContextFreeGrammar) + heap(grammar.getStartSymbol());
+  // The variables and terminals, there are at most as many terminals
+  for(auto& variable: grammar.getVariables()){
+    bytes += 2 * (node(sizeof(std::string)) + heap(variable));
+  }
+  for(auto& production: grammar.getProductions().getProductions()){
+    bytes += node(sizeof(production)) + heap(production.first);
+    for(auto& replacement: production.second){
+      // The replacement, its entry in the reverse productions with the head
+      // and its weight
+      bytes += 3 * (node(sizeof(Replacement)) + heap(replacement)) +
+               2 * (node(sizeof(std::string)) + heap(production.first)) +
+               node(sizeof(double));
+    }
+  }
+  // The BitsetParser built with the grammar
+  bytes += grammar.getBitsetParser().getBytes();
+  return bytes;
+}
+
+CYK::MemoryEstimate CYK::Memory::estimate(
+    const CYK::ContextFreeGrammar &grammar, std::size_t length) {
+  MemoryEstimate estimate;
+  estimate.length = length;
+  estimate.cells = length * (length + 1) / 2;
+  estimate.grammarBytes = bytesOf(grammar);
+
+  // A cell with every variable, the variables are copied into the cells
+  const std::vector<std::string> variables = grammar.getVariables();
+  std::size_t fullCell = 0;
+  for(auto& variable: variables){
+    fullCell += node(sizeof(std::string)) + heapOfCopy(variable.size());
+  }
+  // The rows are copied into the table, so their capacity is their size
+  estimate.tableBytes = sizeof(Table) +
+      allocation(length * sizeof(std::vector<TableCell>)) +
+      length * 2 * sizeof(void*) +
+      estimate.cells * (sizeof(TableCell) + fullCell);
+
+  const std::size_t words = (variables.size() + 63) / 64;
+  estimate.chartBytes = sizeof(Chart) +
+      allocation(estimate.cells * words * sizeof(std::uint64_t)) +
+      allocation(variables.size() * sizeof(std::string)) +
+      allocation(variables.size() * sizeof(void*));
+  for(auto& variable: variables){
+    estimate.chartBytes += 2 * heapOfCopy(variable.size()) +
+                           node(sizeof(std::string) + sizeof(std::size_t));
+  }
+  return estimate;
+}
+
+CYK::MemoryMeter &CYK::MemoryMeter::global() {
+  static MemoryMeter meter;
+  return meter;
+}
+
+void CYK::MemoryMeter::enable() {
+  peak = current.load();
+  enabled = true;
+}
+
+bool CYK::MemoryMeter::isEnabled() const {
+  return enabled.load(std::memory_order_relaxed);
+}
+
+void CYK::MemoryMeter::add(std::size_t bytes) {
+  const std::size_t now = current.fetch_add(bytes) + bytes;
+  std::size_t seen = peak.load(std::memory_order_relaxed);
+  while(now > seen && !peak.compare_exchange_weak(seen, now)){}
+}
+
+void CYK::MemoryMeter::release(std::size_t bytes) {
+  current.fetch_sub(bytes);
+}
+
+std::size_t CYK::MemoryMeter::getCurrent() const {
+  return current.load();
+}
+
+std::size_t CYK::MemoryMeter::getPeak() const {
+  return peak.load();
+}
+
+CYK::MemoryReservation::MemoryReservation(MemoryMeter &meter, std::size_t bytes)
+    : meter(meter), bytes(bytes) {
+  meter.add(bytes);
+}
+
+CYK::MemoryReservation::~MemoryReservation() {
+  meter.release(bytes);
+}
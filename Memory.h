@@ -0,0 +1,133 @@
+//============================================================================
+// Name        : Memory.h
+// Author      : Tobias Wilfert
+//============================================================================
+
+#ifndef CYK__MEMORY_H_
+#define CYK__MEMORY_H_
+
+#include <atomic>
+#include <cstdint>
+
+#include "Chart.h"
+#include "ContextFreeGrammar.h"
+
+namespace CYK{
+
+/// The memory a parse of an input is predicted to need before parsing
+struct MemoryEstimate {
+  /// The length of the input
+  std::size_t length = 0;
+
+  /// The number of cells of the table, length * (length + 1) / 2
+  std::size_t cells = 0;
+
+  /// The bytes of the CFG
+  std::size_t grammarBytes = 0;
+
+  /// The bytes of a Table if every variable ended up in every cell, the
+  /// most fillTable can need
+  std::size_t tableBytes = 0;
+
+  /// The bytes of a Chart of the input (exact, it does not depend on the
+  /// contents), what BitsetParser needs besides its own bitsets
+  std::size_t chartBytes = 0;
+};
+
+/**
+ * Estimates the heap memory of the CYK data structures
+ *
+ * The sizes of the containers are exact, the bytes of their allocations are
+ * estimated for the usual implementations: a node of a std::set or std::map
+ * takes four pointers besides its value, strings longer than the small
+ * string buffer have a heap allocation of their capacity and every
+ * allocation has a header of two pointers.
+ */
+class Memory {
+ public:
+  /// @return The bytes of a filled in table including its cells
+  static std::size_t bytesOf(const Table& table);
+
+  /// @return The bytes of a chart including its cells
+  static std::size_t bytesOf(const Chart& chart);
+
+  /// @return The bytes of a CFG including its productions
+  static std::size_t bytesOf(const ContextFreeGrammar& grammar);
+
+  /**
+   * Predicts the memory of parsing an input, without parsing it
+   * @param grammar The CFG
+   * @param length The length of the input
+   * @return The estimate
+   */
+  static MemoryEstimate estimate(const ContextFreeGrammar& grammar,
+                                 std::size_t length);
+};
+
+/**
+ * Keeps track of the bytes of the tables that are alive and the most that
+ * were alive at once
+ *
+ * The parts of the program that create tables add their bytes once they are
+ * filled in and release them once they are done with them, but only while
+ * the meter is enabled: computing the bytes of a table walks all its cells.
+ */
+class MemoryMeter {
+ private:
+  /// Whether the bytes are tracked
+  std::atomic<bool> enabled{false};
+
+  /// The bytes that are alive and the most that were alive at once
+  std::atomic<std::size_t> current{0}, peak{0};
+
+ public:
+  /// @return The meter of the process
+  static MemoryMeter& global();
+
+  /// Starts tracking and forgets the peak so far
+  void enable();
+
+  /// @return Whether the bytes are tracked
+  bool isEnabled() const;
+
+  /// Adds bytes that are now alive
+  void add(std::size_t bytes);
+
+  /// Releases bytes that were added before
+  void release(std::size_t bytes);
+
+  /// @return The bytes that are alive
+  std::size_t getCurrent() const;
+
+  /// @return The most bytes that were alive at once
+  std::size_t getPeak() const;
+};
+
+/// Holds bytes on a meter for as long as it lives, so they are released
+/// even if the work in between throws
+class MemoryReservation {
+ private:
+  /// The meter the bytes were added to
+  MemoryMeter& meter;
+
+  /// The bytes that were added
+  std::size_t bytes;
+
+ public:
+  /**
+   * Adds the bytes to the meter
+   * @param meter The meter to add them to
+   * @param bytes The bytes that are now alive
+   */
+  MemoryReservation(MemoryMeter& meter, std::size_t bytes);
+
+  MemoryReservation(const MemoryReservation&) = delete;
+  MemoryReservation& operator=(const MemoryReservation&) = delete;
+
+  /// Releases the bytes again
+  ~MemoryReservation();
+};
+
+} // namespace CYK
+
+#endif//CYK__MEMORY_H_
@@ -0,0 +1,172 @@
+//============================================================================
+// Name        : OutputPipeline.cpp
+// Author      : Tobias Wilfert
+//============================================================================
+
+#include "OutputPipeline.h"
+
+#include <chrono>
+#include <algorithm>
+
+#include "Trace.h"
+#include "Memory.h"
+
+namespace {
+
+/// Waits a little longer every time it is called while nothing happens
+class Backoff {
+ private:
+  /// The number of times in a row the caller had to wait
+  unsigned int rounds = 0;
+
+ public:
+  /// Yields at first, then sleeps so an idle thread does not burn a core
+  void wait() {
+    if(++rounds < 64){
+      std::this_thread::yield();
+    }else{
+      std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+  }
+
+  /// Called when the caller made progress
+  void reset() {
+    rounds = 0;
+  }
+};
+
+} // namespace
+
+CYK::OutputPipeline::OutputPipeline(CYK::OutputSink &sink,
+                                    std::size_t writerCount,
+                                    std::size_t capacity)
+    : sink(sink), queue(capacity) {
+  for(std::size_t w = 0; w < std::max<std::size_t>(writerCount, 1); ++w){
+    writers.emplace_back(&OutputPipeline::run, this);
+  }
+}
+
+CYK::OutputPipeline::~OutputPipeline() {
+  stop();
+}
+
+void CYK::OutputPipeline::run() {
+  Trace::nameThread("writer");
+  Backoff backoff;
+  Item item;
+  // When the writer started waiting for a table, for the trace
+  bool waiting = false;
+  Trace::Clock::time_point waitBegin;
+  for(;;){
+    if(!queue.tryPop(item)){
+      // Only stop once closing was seen before the queue was found empty
+      if(closing.load(std::memory_order_acquire) && queue.size() == 0){
+        return;
+      }
+      if(!waiting && Trace::isEnabled()){
+        waiting = true;
+        waitBegin = Trace::Clock::now();
+      }
+      backoff.wait();
+      continue;
+    }
+    if(waiting){
+      Trace::record("queue_wait", "output", waitBegin, Trace::Clock::now());
+      waiting = false;
+    }
+    backoff.reset();
+    Trace::Span span{"write", "output"};
+    auto write = [&](){
+      if(item.chart){
+        sink.writeChart(item.input, *item.chart, item.accepted);
+      }else{
+        sink.write(item.input, item.table, item.accepted);
+      }
+    };
+    try{
+      if(sink.isThreadSafe()){
+        write();
+      }else{
+        std::lock_guard<std::mutex> lock(sinkMutex);
+        write();
+      }
+    }catch(...){
+      std::lock_guard<std::mutex> lock(errorMutex);
+      if(!error){ error = std::current_exception(); }
+    }
+    if(item.bytes > 0){ MemoryMeter::global().release(item.bytes); }
+    item = Item{};
+    written.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void CYK::OutputPipeline::submit(std::string input, CYK::Table table,
+                                 bool accepted) {
+  Item item{std::move(input), std::move(table), accepted, std::nullopt};
+  MemoryMeter& meter = MemoryMeter::global();
+  if(meter.isEnabled()){
+    item.bytes = Memory::bytesOf(item.table);
+    meter.add(item.bytes);
+  }
+  push(item);
+}
+
+void CYK::OutputPipeline::submit(std::string input, CYK::Chart chart,
+                                 bool accepted) {
+  Item item{std::move(input), {}, accepted, std::move(chart)};
+  MemoryMeter& meter = MemoryMeter::global();
+  if(meter.isEnabled()){
+    item.bytes = Memory::bytesOf(*item.chart);
+    meter.add(item.bytes);
+  }
+  push(item);
+}
+
+void CYK::OutputPipeline::push(CYK::OutputPipeline::Item &item) {
+  const std::size_t depth = queue.size();
+  depthSum.fetch_add(depth, std::memory_order_relaxed);
+  std::size_t seen = maxDepth.load(std::memory_order_relaxed);
+  while(depth > seen &&
+        !maxDepth.compare_exchange_weak(seen, depth,
+                                        std::memory_order_relaxed)){}
+
+  if(!queue.tryPush(item)){
+    stalls.fetch_add(1, std::memory_order_relaxed);
+    Trace::Span span{"queue_full", "output"};
+    Backoff backoff;
+    while(!queue.tryPush(item)){ backoff.wait(); }
+  }
+  submitted.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool CYK::OutputPipeline::usesChart() const {
+  return sink.usesChart();
+}
+
+void CYK::OutputPipeline::stop() {
+  closing.store(true, std::memory_order_release);
+  for(auto& writer: writers){
+    if(writer.joinable()){ writer.join(); }
+  }
+}
+
+void CYK::OutputPipeline::close() {
+  stop();
+  std::lock_guard<std::mutex> lock(errorMutex);
+  if(error){
+    std::exception_ptr thrown = error;
+    error = nullptr;
+    std::rethrow_exception(thrown);
+  }
+}
+
+CYK::PipelineMetrics CYK::OutputPipeline::getMetrics() const {
+  PipelineMetrics metrics;
+  metrics.submitted = submitted.load();
+  metrics.written = written.load();
+  metrics.maxDepth = maxDepth.load();
+  metrics.averageDepth = metrics.submitted == 0 ? 0.0 :
+      static_cast<double>(depthSum.load()) / metrics.submitted;
+  metrics.stalls = stalls.load();
+  return metrics;
+}
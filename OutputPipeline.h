@@ -0,0 +1,144 @@
+//============================================================================
+// Name        : OutputPipeline.h
+// Author      : Tobias Wilfert
+//============================================================================
+
+#ifndef CYK__OUTPUTPIPELINE_H_
+#define CYK__OUTPUTPIPELINE_H_
+
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <optional>
+#include <exception>
+
+#include "Chart.h"
+#include "OutputSink.h"
+#include "BoundedQueue.h"
+#include "ContextFreeGrammar.h"
+
+namespace CYK{
+
+/// Statistics of an OutputPipeline
+struct PipelineMetrics {
+  /// The number of tables handed to the pipeline
+  std::size_t submitted = 0;
+
+  /// The number of tables written by the sink
+  std::size_t written = 0;
+
+  /// The largest number of tables waiting in the queue seen by submit
+  std::size_t maxDepth = 0;
+
+  /// The average number of tables waiting in the queue seen by submit
+  double averageDepth = 0;
+
+  /// The number of submits that found the queue full and had to wait
+  std::size_t stalls = 0;
+};
+
+/**
+ * Writes tables to a sink on dedicated writer threads
+ *
+ * Parser threads hand their filled in tables to submit and continue parsing,
+ * the rendering and writing happens on the writer threads. The tables wait in
+ * a bounded lock-free queue; when it is full submit waits (back-pressure) so
+ * slow output can not make the waiting tables use unbounded memory.
+ */
+class OutputPipeline {
+ private:
+  /// A table waiting to be written, a chart for a sink that uses charts
+  struct Item {
+    std::string input;
+    Table table;
+    bool accepted = false;
+    std::optional<Chart> chart;
+
+    /// The bytes of the table added to the MemoryMeter, 0 if none
+    std::size_t bytes = 0;
+  };
+
+  /// The sink the tables are written to
+  OutputSink& sink;
+
+  /// Serializes the writes if the sink is not thread safe
+  std::mutex sinkMutex;
+
+  /// The tables waiting to be written
+  BoundedQueue<Item> queue;
+
+  /// Set once no more tables will be submitted
+  std::atomic<bool> closing{false};
+
+  /// The writer threads
+  std::vector<std::thread> writers;
+
+  /// Counters behind PipelineMetrics
+  std::atomic<std::size_t> submitted{0}, written{0}, maxDepth{0},
+      depthSum{0}, stalls{0};
+
+  /// The first exception thrown by the sink
+  std::exception_ptr error;
+
+  /// Protects error
+  std::mutex errorMutex;
+
+  /// The loop of a writer thread
+  void run();
+
+  /// Hands an item to the writer threads, waits while the queue is full
+  void push(Item& item);
+
+  /// Stops and joins the writer threads once the queue is empty
+  void stop();
+
+ public:
+  /**
+   * Starts the writer threads
+   * @param sink The sink, needs to outlive the pipeline
+   * @param writerCount The number of writer threads (at least 1)
+   * @param capacity The number of tables that can wait in the queue
+   */
+  OutputPipeline(OutputSink& sink, std::size_t writerCount = 1,
+                 std::size_t capacity = 64);
+
+  OutputPipeline(const OutputPipeline&) = delete;
+  OutputPipeline& operator=(const OutputPipeline&) = delete;
+
+  /// Writes the remaining tables and stops the writer threads
+  ~OutputPipeline();
+
+  /**
+   * Hands a table to the writer threads, waits while the queue is full
+   * @param input The input string of the table
+   * @param table The filled in table
+   * @param accepted Whether input is in the language of the CFG
+   */
+  void submit(std::string input, Table table, bool accepted);
+
+  /**
+   * Hands a chart to the writer threads, waits while the queue is full
+   * @param input The input string of the chart
+   * @param chart The filled in chart
+   * @param accepted Whether input is in the language of the CFG
+   */
+  void submit(std::string input, Chart chart, bool accepted);
+
+  /// @return Whether the sink takes charts, see OutputSink::usesChart
+  bool usesChart() const;
+
+  /**
+   * Writes the remaining tables and stops the writer threads
+   * @throws The first exception thrown by the sink
+   */
+  void close();
+
+  /// @return The statistics of the pipeline so far
+  PipelineMetrics getMetrics() const;
+};
+
+} // namespace CYK
+
+#endif//CYK__OUTPUTPIPELINE_H_
@@ -0,0 +1,298 @@
+//============================================================================
+// Name        : OutputSink.cpp
+// Author      : Tobias Wilfert
+//============================================================================
+
+#include "OutputSink.h"
+
+#include <cctype>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+
+#include "Hash.h"
+#include "Chart.h"
+#include "BufferedWriter.h"
+
+namespace {
+
+/// Writes a string as a JSON string literal
+void writeJSONString(CYK::BufferedWriter &writer, const std::string &text) {
+  static const char hex[] = "0123456789abcdef";
+  writer.write('"');
+  for(char c: text){
+    if(c == '"' || c == '\\'){
+      writer.write('\\');
+      writer.write(c);
+    }else if(static_cast<unsigned char>(c) < 0x20){
+      writer.write("\\u00");
+      writer.write(hex[(c >> 4) & 0xf]);
+      writer.write(hex[c & 0xf]);
+    }else{
+      writer.write(c);
+    }
+  }
+  writer.write('"');
+}
+
+/**
+ * The lock of the file at a path, the sinks writing a file per input hold it
+ * while writing so two writers of an equal input don't write the same file
+ * at once. Paths share a fixed number of locks, equal paths always share one.
+ * @param path The path of the file
+ * @return The lock of the file
+ */
+std::mutex &fileLock(const std::string &path) {
+  static std::mutex locks[64];
+  return locks[std::hash<std::string>{}(path) % 64];
+}
+
+/// Writes a string as a CSV field, quoted only if needed
+void writeCSVField(CYK::BufferedWriter &writer, const std::string &text) {
+  if(text.find_first_of(",\"\r\n") == std::string::npos){
+    writer.write(text);
+    return;
+  }
+  writer.write('"');
+  for(char c: text){
+    if(c == '"'){ writer.write('"'); }
+    writer.write(c);
+  }
+  writer.write('"');
+}
+
+} // namespace
+
+std::unique_ptr<CYK::OutputSink> CYK::OutputSink::create(
+    const std::string &format, const CYK::ContextFreeGrammar &grammar,
+    const CYK::SinkOptions &options) {
+  const std::string& path = options.path;
+  if(format == "none"){ return std::make_unique<NullSink>(); }
+  if(format == "html"){
+    return std::make_unique<HTMLSink>(options.view, &grammar,
+                                      options.hashNames);
+  }
+  if(format == "json"){ return std::make_unique<JSONSink>(path); }
+  if(format == "csv"){ return std::make_unique<CSVSink>(path); }
+  if(format == "binary"){
+    return std::make_unique<BinarySink>(path, grammar.getVariables());
+  }
+  if(format == "chart"){
+    return std::make_unique<ChartSink>(grammar, options.hashNames);
+  }
+  if(format == "container"){
+    return std::make_unique<ContainerSink>(grammar, path);
+  }
+  return nullptr;
+}
+
+std::string CYK::OutputSink::fileName(const std::string &prefix,
+                                      const std::string &input,
+                                      const std::string &extension,
+                                      bool hashName) {
+  // Well below the 255 byte limit of common file systems
+  const std::size_t maxLength = 128;
+  // Names starting with "h-" are reserved for hashes, so a safe input can't
+  // collide with the hash of another input
+  bool safe = !hashName && !input.empty() && input.size() <= maxLength &&
+      input != "." && input != ".." && input.rfind("h-", 0) != 0;
+  for(std::size_t c = 0; safe && c < input.size(); ++c){
+    safe = std::isalnum(static_cast<unsigned char>(input[c])) ||
+        input[c] == '-' || input[c] == '_' || input[c] == '.';
+  }
+  return prefix + (safe ? input : "h-" + toHex(hash(input))) + extension;
+}
+
+void CYK::OutputSink::writeChart(const std::string &input,
+                                 const CYK::Chart &chart, bool accepted) {
+  write(input, chart.toTable(), accepted);
+}
+
+bool CYK::OutputSink::usesChart() const {
+  return false;
+}
+
+bool CYK::OutputSink::isThreadSafe() const {
+  return false;
+}
+
+void CYK::NullSink::write(const std::string &, const CYK::Table &, bool) {}
+
+void CYK::NullSink::writeChart(const std::string &, const CYK::Chart &, bool) {}
+
+bool CYK::NullSink::usesChart() const {
+  return true;
+}
+
+bool CYK::NullSink::isThreadSafe() const {
+  return true;
+}
+
+CYK::HTMLSink::HTMLSink(const CYK::HTMLView &view,
+                        const CYK::ContextFreeGrammar *grammar,
+                        bool hashNames)
+    : view(view), grammar(grammar), hashNames(hashNames) {}
+
+void CYK::HTMLSink::write(const std::string &input, const CYK::Table &table,
+                          bool) {
+  const std::string path = fileName("CYKTable-", input, ".html", hashNames);
+  const std::lock_guard<std::mutex> lock(fileLock(path));
+  std::ofstream out(path);
+  if(!out){ throw std::runtime_error("Could not create " + path); }
+  HTMLWriter{out}.write(input, table, view, grammar);
+}
+
+bool CYK::HTMLSink::isThreadSafe() const {
+  return true;
+}
+
+CYK::StreamSink::StreamSink(std::string path, bool binary)
+    : path(std::move(path)), binary(binary) {}
+
+std::ostream &CYK::StreamSink::stream() {
+  if(out){ return *out; }
+  if(path == "-"){
+    out = &std::cout;
+  }else{
+    file.open(path, binary ? std::ios::out | std::ios::binary : std::ios::out);
+    if(!file){ throw std::runtime_error("Could not create " + path); }
+    out = &file;
+  }
+  writeHeader(*out);
+  return *out;
+}
+
+void CYK::StreamSink::writeHeader(std::ostream &) {}
+
+CYK::JSONSink::JSONSink(const std::string &path) : StreamSink(path, false) {}
+
+void CYK::JSONSink::write(const std::string &input, const CYK::Table &table,
+                          bool accepted) {
+  BufferedWriter writer{stream()};
+  writer.write("{\"input\":");
+  writeJSONString(writer, input);
+  writer.write(accepted ? ",\"accepted\":true,\"table\":["
+                        : ",\"accepted\":false,\"table\":[");
+  for(std::size_t i = 0; i < table.size(); ++i){
+    writer.write(i == 0 ? "[" : ",[");
+    for(std::size_t j = 0; j < table[i].size(); ++j){
+      writer.write(j == 0 ? "[" : ",[");
+      bool first = true;
+      for(auto& var: table[i][j]){
+        if(!first){ writer.write(','); }
+        writeJSONString(writer, var);
+        first = false;
+      }
+      writer.write(']');
+    }
+    writer.write(']');
+  }
+  writer.write("]}\n");
+}
+
+CYK::CSVSink::CSVSink(const std::string &path) : StreamSink(path, false) {}
+
+void CYK::CSVSink::writeHeader(std::ostream &output) {
+  output << "input,begin,end,variable\n";
+}
+
+void CYK::CSVSink::write(const std::string &input, const CYK::Table &table,
+                         bool) {
+  BufferedWriter writer{stream()};
+  for(std::size_t i = 0; i < table.size(); ++i){
+    for(std::size_t j = 0; j < table[i].size(); ++j){
+      for(auto& var: table[i][j]){
+        writeCSVField(writer, input);
+        writer.write(',');
+        writer.write(static_cast<unsigned long long>(j));
+        writer.write(',');
+        writer.write(static_cast<unsigned long long>(j + i + 1));
+        writer.write(',');
+        writeCSVField(writer, var);
+        writer.write('\n');
+      }
+    }
+  }
+}
+
+CYK::BinarySink::BinarySink(const std::string &path,
+                            std::vector<std::string> symbols)
+    : StreamSink(path, true), symbols(std::move(symbols)) {}
+
+void CYK::BinarySink::writeHeader(std::ostream &output) {
+  BufferedWriter writer{output};
+  writer.write("CYKB");
+  writer.writeLittleEndian<std::uint32_t>(1);
+  writer.writeLittleEndian<std::uint32_t>(symbols.size());
+  for(auto& symbol: symbols){
+    writer.writeLittleEndian<std::uint32_t>(symbol.size());
+    writer.write(symbol);
+  }
+}
+
+void CYK::BinarySink::write(const std::string &input, const CYK::Table &table,
+                            bool accepted) {
+  writeChart(input, Chart{table, symbols}, accepted);
+}
+
+void CYK::BinarySink::writeChart(const std::string &input,
+                                 const CYK::Chart &chart, bool accepted) {
+  BufferedWriter writer{stream()};
+  writer.writeLittleEndian<std::uint32_t>(input.size());
+  writer.write(input);
+  writer.write(static_cast<char>(accepted));
+  for(std::uint64_t word: chart.getCells()){
+    writer.writeLittleEndian(word);
+  }
+}
+
+bool CYK::BinarySink::usesChart() const {
+  return true;
+}
+
+CYK::ChartSink::ChartSink(const CYK::ContextFreeGrammar &grammar,
+                          bool hashNames)
+    : grammar(grammar), symbols(grammar.getVariables()),
+      hashNames(hashNames) {}
+
+void CYK::ChartSink::write(const std::string &input, const CYK::Table &table,
+                           bool accepted) {
+  writeChart(input, Chart{table, symbols}, accepted);
+}
+
+void CYK::ChartSink::writeChart(const std::string &input,
+                                const CYK::Chart &chart, bool accepted) {
+  const std::string path = fileName("CYKChart-", input, ".chart", hashNames);
+  const std::lock_guard<std::mutex> lock(fileLock(path));
+  std::ofstream out(path, std::ios::binary);
+  if(!out){ throw std::runtime_error("Could not create " + path); }
+  ChartFile::write(out, input, chart, accepted, &grammar);
+}
+
+bool CYK::ChartSink::usesChart() const {
+  return true;
+}
+
+bool CYK::ChartSink::isThreadSafe() const {
+  return true;
+}
+
+CYK::ContainerSink::ContainerSink(const CYK::ContextFreeGrammar &grammar,
+                                  const std::string &path)
+    : grammar(grammar), symbols(grammar.getVariables()), path(path) {}
+
+void CYK::ContainerSink::write(const std::string &input,
+                               const CYK::Table &table, bool accepted) {
+  writeChart(input, Chart{table, symbols}, accepted);
+}
+
+void CYK::ContainerSink::writeChart(const std::string &input,
+                                    const CYK::Chart &chart, bool accepted) {
+  if(!container){ container = std::make_unique<ChartContainer>(path); }
+  container->add(input, chart, accepted, &grammar);
+}
+
+bool CYK::ContainerSink::usesChart() const {
+  return true;
+}
@@ -0,0 +1,322 @@
+//============================================================================
+// Name        : OutputSink.h
+// Author      : Tobias Wilfert
+//============================================================================
+
+#ifndef CYK__OUTPUTSINK_H_
+#define CYK__OUTPUTSINK_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <ostream>
+
+#include "ChartFile.h"
+#include "HTMLWriter.h"
+#include "ContextFreeGrammar.h"
+
+namespace CYK{
+
+/// Settings of the output sinks
+struct SinkOptions {
+  /// The file the sinks that write all tables to one file use, "-" for stdout
+  std::string path = "-";
+
+  /// The part of the tables the html sink shows
+  HTMLView view;
+
+  /// Whether the sinks writing a file per input always name it after the hash
+  /// of the input, not only when the input is no safe file name
+  bool hashNames = false;
+};
+
+/// Receives the filled in CYK tables
+class OutputSink {
+ public:
+  virtual ~OutputSink() = default;
+
+  /**
+   * Outputs a filled in table
+   * @param input The input string of the table
+   * @param table The filled in table
+   * @param accepted Whether input is in the language of the CFG
+   */
+  virtual void write(const std::string& input, const Table& table,
+                     bool accepted) = 0;
+
+  /**
+   * Outputs a filled in chart, by default as the Table of the chart
+   * @param input The input string of the chart
+   * @param chart The filled in chart, with the variables of the CFG
+   * @param accepted Whether input is in the language of the CFG
+   */
+  virtual void writeChart(const std::string& input, const Chart& chart,
+                          bool accepted);
+
+  /**
+   * Whether the sink only needs the Chart of a table, the parsers then call
+   * writeChart instead of write and do not build a Table
+   * @return False unless the sink overrides it
+   */
+  virtual bool usesChart() const;
+
+  /**
+   * Whether write may be called from several threads at the same time,
+   * otherwise the OutputPipeline serializes the calls
+   * @return False unless the sink overrides it
+   */
+  virtual bool isThreadSafe() const;
+
+  /**
+   * Creates a sink for a format
+   * @param format One of "none", "html", "json", "csv", "binary", "chart" or
+   *    "container"
+   * @param grammar The CFG the tables are for, needs to outlive the sink
+   * @param options The settings of the sink
+   * @return The sink or nullptr if the format is unknown
+   */
+  static std::unique_ptr<OutputSink> create(
+      const std::string& format, const ContextFreeGrammar& grammar,
+      const SinkOptions& options = {});
+
+  /**
+   * Get the name of the file for an input
+   * The input is used in the name if it is short and only contains letters,
+   * digits, '-', '_' and '.', otherwise "h-" followed by the hash of the
+   * input is used (inputs starting with "h-" are hashed as well)
+   * @param prefix The start of the name
+   * @param input The input
+   * @param extension The end of the name
+   * @param hashName Whether the hash should be used in any case
+   * @return prefix + (input or "h-" and its hash) + extension
+   */
+  static std::string fileName(const std::string& prefix,
+                              const std::string& input,
+                              const std::string& extension, bool hashName);
+};
+
+/// Discards the tables, for when only whether the input is accepted matters
+class NullSink : public OutputSink {
+ public:
+  void write(const std::string&, const Table&, bool) override;
+
+  void writeChart(const std::string&, const Chart&, bool) override;
+
+  bool usesChart() const override;
+
+  bool isThreadSafe() const override;
+};
+
+/**
+ * Writes every table to its own HTML file named "CYKTable-<input>.html"
+ * (see OutputSink::fileName)
+ */
+class HTMLSink : public OutputSink {
+ private:
+  /// The part of the tables that is shown
+  HTMLView view;
+
+  /// The CFG of the tables, if known
+  const ContextFreeGrammar* grammar;
+
+  /// Whether the files are always named after the hash of the input
+  bool hashNames;
+
+ public:
+  /**
+   * Creates a sink
+   * @param view The part of the tables that is shown
+   * @param grammar The CFG of the tables, needed for HTMLView::Mode::Derivation
+   * @param hashNames Whether the files are always named after the hash
+   */
+  explicit HTMLSink(const HTMLView& view = {},
+                    const ContextFreeGrammar* grammar = nullptr,
+                    bool hashNames = false);
+
+  void write(const std::string& input, const Table& table,
+             bool accepted) override;
+
+  /// Every input has its own file, writes of equal inputs are serialized by
+  /// a lock per file name
+  bool isThreadSafe() const override;
+};
+
+/**
+ * A sink that writes all tables to a single file (or stdout), the file is
+ * only created by the first write so nothing is left behind if no table is
+ * written
+ */
+class StreamSink : public OutputSink {
+ private:
+  /// The path of the file, "-" for stdout
+  std::string path;
+
+  /// Whether the file is opened in binary mode
+  bool binary;
+
+  /// The file, if not writing to stdout
+  std::ofstream file;
+
+  /// The stream that is written to, null until the first write
+  std::ostream* out = nullptr;
+
+ protected:
+  /**
+   * Get the output, opens it and writes the header on the first call
+   * @return The stream that is written to
+   * @throws std::runtime_error If the file can't be created
+   */
+  std::ostream& stream();
+
+  /**
+   * Writes what comes before the first table, nothing unless overridden
+   * @param output The stream that is written to
+   */
+  virtual void writeHeader(std::ostream& output);
+
+ public:
+  /**
+   * Creates a sink, the file is created by the first write
+   * @param path The path of the file, "-" for stdout
+   * @param binary Whether the file should be opened in binary mode
+   */
+  StreamSink(std::string path, bool binary);
+};
+
+/**
+ * Writes every table as one line of compact JSON:
+ * {"input":"ab","accepted":true,"table":[[["A"],["B"]],[["S"]]]}
+ * where table[i][j] holds the variables that produce input.substr(j, i+1)
+ */
+class JSONSink : public StreamSink {
+ public:
+  /// @param path The path of the file, "-" for stdout
+  explicit JSONSink(const std::string& path);
+
+  void write(const std::string& input, const Table& table,
+             bool accepted) override;
+};
+
+/**
+ * Writes the tables as CSV with the header "input,begin,end,variable",
+ * one line for every variable that produces input[begin, end)
+ */
+class CSVSink : public StreamSink {
+ public:
+  /// @param path The path of the file, "-" for stdout
+  explicit CSVSink(const std::string& path);
+
+  void write(const std::string& input, const Table& table,
+             bool accepted) override;
+
+ protected:
+  void writeHeader(std::ostream& output) override;
+};
+
+/**
+ * Writes the tables as bitsets, all integers are little endian:
+ *   header:  "CYKB", u32 version (1), u32 number of variables,
+ *            every variable as u32 length followed by its characters
+ *   records: u32 length of the input, the input, u8 accepted,
+ *            the cells of the Chart (each Chart::getWords() u64 words)
+ */
+class BinarySink : public StreamSink {
+ private:
+  /// The variables, their index is their bit in a cell
+  std::vector<std::string> symbols;
+
+ public:
+  /**
+   * Creates a sink, the file and its header are written by the first write
+   * @param path The path of the file, "-" for stdout
+   * @param symbols The variables of the CFG
+   */
+  BinarySink(const std::string& path, std::vector<std::string> symbols);
+
+  void write(const std::string& input, const Table& table,
+             bool accepted) override;
+
+  void writeChart(const std::string& input, const Chart& chart,
+                  bool accepted) override;
+
+  bool usesChart() const override;
+
+ protected:
+  void writeHeader(std::ostream& output) override;
+};
+
+/**
+ * Writes every table to its own chart file (see ChartFile) named
+ * "CYKChart-<input>.chart" (see OutputSink::fileName), including backpointers
+ */
+class ChartSink : public OutputSink {
+ private:
+  /// The CFG, used for the variables and the backpointers
+  const ContextFreeGrammar& grammar;
+
+  /// The variables of the CFG
+  std::vector<std::string> symbols;
+
+  /// Whether the files are always named after the hash of the input
+  bool hashNames;
+
+ public:
+  /**
+   * Creates a sink
+   * @param grammar The CFG the tables are for, needs to outlive the sink
+   * @param hashNames Whether the files are always named after the hash
+   */
+  explicit ChartSink(const ContextFreeGrammar& grammar, bool hashNames = false);
+
+  void write(const std::string& input, const Table& table,
+             bool accepted) override;
+
+  void writeChart(const std::string& input, const Chart& chart,
+                  bool accepted) override;
+
+  bool usesChart() const override;
+
+  /// Every input has its own file, writes of equal inputs are serialized by
+  /// a lock per file name
+  bool isThreadSafe() const override;
+};
+
+/**
+ * Writes all tables as charts (including backpointers) into a single
+ * container file (see ChartContainer), appending them one after the other
+ */
+class ContainerSink : public OutputSink {
+ private:
+  /// The CFG, used for the variables and the backpointers
+  const ContextFreeGrammar& grammar;
+
+  /// The variables of the CFG
+  std::vector<std::string> symbols;
+
+  /// The path of the container file
+  std::string path;
+
+  /// The container, created by the first write
+  std::unique_ptr<ChartContainer> container;
+
+ public:
+  /**
+   * Creates a sink, the container file is created by the first write
+   * @param grammar The CFG the tables are for, needs to outlive the sink
+   * @param path The path of the container file
+   */
+  ContainerSink(const ContextFreeGrammar& grammar, const std::string& path);
+
+  void write(const std::string& input, const Table& table,
+             bool accepted) override;
+
+  void writeChart(const std::string& input, const Chart& chart,
+                  bool accepted) override;
+
+  bool usesChart() const override;
+};
+
+} // namespace CYK
+
+#endif//CYK__OUTPUTSINK_H_
@@ -0,0 +1,86 @@
+//============================================================================
+// Name        : ParserContext.cpp
+// Author      : Tobias Wilfert
+//============================================================================
+
+#include "ParserContext.h"
+
+#include <new>
+#include <algorithm>
+#include <type_traits>
+
+namespace {
+
+/// Makes room for a number of elements, at least doubling the capacity
+template<typename Vector>
+void grow(Vector& vector, std::size_t size) {
+  if(size > vector.capacity()){
+    vector.reserve(std::max(size, 2 * vector.capacity()));
+  }
+}
+
+// Growing a row moves its cells, a copy would not allocate from the arena
+static_assert(std::is_nothrow_move_constructible<CYK::TableCell>::value,
+              "The cells of a row need to be moved when it grows");
+
+} // namespace
+
+CYK::ParserContext::ParserContext() : pair(2), terminal(1) {}
+
+CYK::Replacement &CYK::ParserContext::getPair() {
+  return pair;
+}
+
+CYK::Replacement &CYK::ParserContext::getTerminal() {
+  return terminal;
+}
+
+CYK::Table &CYK::ParserContext::getTable(std::size_t size, bool shortNames) {
+  clearTable();
+  this->shortNames = shortNames;
+  grow(table, size);
+  table.resize(size);
+  for(std::size_t i = 0; i < size; ++i){
+    auto& row = table[i];
+    grow(row, size - i);
+    if(row.size() > size - i){ row.resize(size - i); }
+    while(row.size() < size - i){ row.emplace_back(&arena); }
+  }
+  return table;
+}
+
+void CYK::ParserContext::clearTable() {
+  for(auto& row: table){
+    for(auto& cell: row){
+      if(shortNames){
+        // The nodes are in the arena and the names own no memory, so nothing
+        // is lost by overwriting the set without destroying it
+        new (&cell) TableCell(&arena);
+      }else{
+        cell.clear();
+      }
+    }
+  }
+  arena.reset();
+}
+
+CYK::Chart &CYK::ParserContext::getChart(
+    const std::vector<std::string> &symbols, std::size_t size) {
+  if(!chart || chart->getSymbols() != symbols){
+    chart = std::make_unique<Chart>(symbols, size);
+  }else{
+    chart->reset(size);
+  }
+  return *chart;
+}
+
+std::uint64_t *CYK::ParserContext::getBits(std::size_t count) {
+  grow(bits, count);
+  bits.assign(count, 0);
+  return bits.data();
+}
+
+CYK::ParserContext &CYK::ParserContext::local() {
+  thread_local ParserContext context;
+  return context;
+}
@@ -0,0 +1,108 @@
+//============================================================================
+// Name        : ParserContext.h
+// Author      : Tobias Wilfert
+//============================================================================
+
+#ifndef CYK__PARSERCONTEXT_H_
+#define CYK__PARSERCONTEXT_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "Arena.h"
+#include "Chart.h"
+#include "ContextFreeGrammar.h"
+
+namespace CYK{
+
+/**
+ * The buffers and scratch space of the parsers, reused from one parse to the
+ * next so parsing inputs of similar lengths does not allocate
+ *
+ * A context holds the keys the productions are looked up with, a Table for
+ * ContextFreeGrammar::fillTable and a Chart and the rows of its variables
+ * for BitsetParser::fill (which ContextFreeGrammar::recognize uses). Buffers
+ * that are too small grow to at least twice their size and are never shrunk.
+ * The sets in the cells of the table allocate from the Arena of the context,
+ * clearTable frees all of them at once by resetting the arena. A context
+ * may only be used by one thread at a time; local gives every thread its own,
+ * which is what the parsers use unless they are given one (so batch and
+ * server mode reuse one context per parser thread).
+ */
+class ParserContext {
+ private:
+  /// The keys a pair of variables and a terminal are looked up with
+  Replacement pair;
+  Replacement terminal;
+
+  /// The memory of the sets in the cells of the table
+  Arena arena;
+
+  /// The reused table, its cells allocate from arena
+  Table table;
+
+  /// Whether the variables in the cells of the table own no memory, see
+  /// getTable
+  bool shortNames = false;
+
+  /// The reused chart, nullptr until one is needed
+  std::unique_ptr<Chart> chart;
+
+  /// The reused words of BitsetParser::fill
+  std::vector<std::uint64_t> bits;
+
+ public:
+  ParserContext();
+
+  ParserContext(const ParserContext&) = delete;
+  ParserContext& operator=(const ParserContext&) = delete;
+
+  /// @return A replacement of two symbols to look up pairs with
+  Replacement& getPair();
+
+  /// @return A replacement of one symbol to look up terminals with
+  Replacement& getTerminal();
+
+  /**
+   * Get the reused table with empty cells for an input, its rows keep the
+   * capacity they had and its cells allocate from the arena of the context
+   * @param size The length of the input
+   * @param shortNames Whether every variable that is put into the cells fits
+   *    into the small string buffer of a std::string, clearTable then does
+   *    not have to visit the nodes of the cells
+   * @return The table, valid until the next call
+   */
+  Table& getTable(std::size_t size, bool shortNames);
+
+  /**
+   * Empties the cells of the reused table and resets the arena, which frees
+   * the nodes of all cells at once. With short names the cells are forgotten
+   * without visiting their nodes, otherwise the nodes are destroyed to free
+   * the longer names. The rows and the blocks of the arena are kept.
+   */
+  void clearTable();
+
+  /**
+   * Get the reused chart with empty cells for an input
+   * @param symbols The variables of the chart
+   * @param size The length of the input
+   * @return The chart, valid until the next call
+   */
+  Chart& getChart(const std::vector<std::string>& symbols, std::size_t size);
+
+  /**
+   * Get reused words that are all 0
+   * @param count The number of words
+   * @return The first word, valid until the next call
+   */
+  std::uint64_t* getBits(std::size_t count);
+
+  /// @return The context of the calling thread
+  static ParserContext& local();
+};
+
+} // namespace CYK
+
+#endif//CYK__PARSERCONTEXT_H_
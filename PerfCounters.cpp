@@ -0,0 +1,189 @@
+//============================================================================
+// Name        : PerfCounters.cpp
+// Author      : Tobias Wilfert
+//============================================================================
+
+#include "PerfCounters.h"
+
+#include <cerrno>
+#include <string>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#define CYK_HAS_PERF 1
+#endif
+
+namespace {
+
+/// The names of the PerfEvents in JSON
+const char* const eventNames[] = {"cycles", "instructions", "cache_misses",
+                                  "branch_misses"};
+
+/// The names of the PerfPhases in JSON
+const char* const phaseNames[] = {"first_row", "splits", "output"};
+
+} // namespace
+
+std::int64_t CYK::PerfSample::operator[](CYK::PerfEvent event) const {
+  return counts[static_cast<std::size_t>(event)];
+}
+
+CYK::PerfSample CYK::PerfSample::operator+(const CYK::PerfSample &other) const {
+  PerfSample sum;
+  for(std::size_t e = 0; e < perfEventCount; ++e){
+    if(counts[e] >= 0 && other.counts[e] >= 0){
+      sum.counts[e] = counts[e] + other.counts[e];
+    }
+  }
+  return sum;
+}
+
+json CYK::PerfSample::toJson() const {
+  json j;
+  for(std::size_t e = 0; e < perfEventCount; ++e){
+    j[eventNames[e]] = counts[e] >= 0 ? json(counts[e]) : json(nullptr);
+  }
+  const std::int64_t cycles = (*this)[PerfEvent::Cycles];
+  const std::int64_t instructions = (*this)[PerfEvent::Instructions];
+  j["ipc"] = cycles > 0 && instructions >= 0 ?
+             json(static_cast<double>(instructions) / cycles) : json(nullptr);
+  return j;
+}
+
+CYK::PerfCounters::PerfCounters() {
+#ifdef CYK_HAS_PERF
+  const std::uint64_t configs[] = {
+      PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+      PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+  int error = 0;
+  bool any = false;
+  for(std::size_t e = 0; e < perfEventCount; ++e){
+    perf_event_attr attributes{};
+    attributes.size = sizeof(attributes);
+    attributes.type = PERF_TYPE_HARDWARE;
+    attributes.config = configs[e];
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+    attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+                             PERF_FORMAT_TOTAL_TIME_RUNNING;
+    // The calling thread on any CPU
+    fds[e] = static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1,
+                                      -1, PERF_FLAG_FD_CLOEXEC));
+    if(fds[e] < 0){
+      error = errno;
+    }else{
+      any = true;
+    }
+  }
+  if(!any){
+    throw std::runtime_error(std::string{"Hardware counters are not "
+                                         "available: "} +
+                             std::strerror(error));
+  }
+  start();
+#else
+  throw std::runtime_error("Hardware counters are only available on Linux");
+#endif
+}
+
+CYK::PerfCounters::~PerfCounters() {
+#ifdef CYK_HAS_PERF
+  for(int fd: fds){
+    if(fd >= 0){ close(fd); }
+  }
+#endif
+}
+
+CYK::PerfSample CYK::PerfCounters::read() const {
+  PerfSample sample;
+#ifdef CYK_HAS_PERF
+  for(std::size_t e = 0; e < perfEventCount; ++e){
+    // The value, the time enabled and the time running
+    std::uint64_t values[3];
+    if(fds[e] < 0 ||
+       ::read(fds[e], values, sizeof(values)) != sizeof(values)){
+      continue;
+    }
+    // Not scheduled on the PMU yet, or only part of the time
+    if(values[2] == 0){
+      sample.counts[e] = 0;
+      continue;
+    }
+    double scale = values[2] < values[1] ?
+                   static_cast<double>(values[1]) / values[2] : 1.0;
+    sample.counts[e] = static_cast<std::int64_t>(values[0] * scale);
+  }
+#endif
+  return sample;
+}
+
+void CYK::PerfCounters::start() {
+  begin = read();
+}
+
+CYK::PerfSample CYK::PerfCounters::stop() const {
+  PerfSample now = read();
+  for(std::size_t e = 0; e < perfEventCount; ++e){
+    if(now.counts[e] >= 0 && begin.counts[e] >= 0){
+      now.counts[e] -= begin.counts[e];
+    }else{
+      now.counts[e] = -1;
+    }
+  }
+  return now;
+}
+
+bool CYK::PerfCounters::isSupported() {
+#ifdef CYK_HAS_PERF
+  return true;
+#else
+  return false;
+#endif
+}
+
+CYK::PerfProfile::PerfProfile() {
+  for(auto& phase: phases){ phase.counts.fill(0); }
+}
+
+json CYK::PerfProfile::toJson() const {
+  json j;
+  PerfSample total;
+  total.counts.fill(0);
+  for(std::size_t p = 0; p < perfPhaseCount; ++p){
+    j[phaseNames[p]] = phases[p].toJson();
+    total = total + phases[p];
+  }
+  j["total"] = total.toJson();
+  return j;
+}
+
+CYK::PerfRecording::PerfRecording(CYK::PerfCounters &counters,
+                                  CYK::PerfProfile &profile)
+    : counters(counters), profile(profile), previous(current()) {
+  current() = this;
+}
+
+CYK::PerfRecording::~PerfRecording() {
+  current() = previous;
+}
+
+CYK::PerfRecording *&CYK::PerfRecording::current() {
+  thread_local PerfRecording* recording = nullptr;
+  return recording;
+}
+
+CYK::PerfPhaseScope::PerfPhaseScope(CYK::PerfPhase phase)
+    : recording(PerfRecording::current()), phase(phase) {
+  if(recording){ recording->counters.start(); }
+}
+
+CYK::PerfPhaseScope::~PerfPhaseScope() {
+  if(!recording){ return; }
+  PerfSample& sum = recording->profile.phases[static_cast<std::size_t>(phase)];
+  sum = sum + recording->counters.stop();
+}
@@ -0,0 +1,159 @@
+//============================================================================
+// Name        : PerfCounters.h
+// Author      : Tobias Wilfert
+//============================================================================
+
+#ifndef CYK__PERFCOUNTERS_H_
+#define CYK__PERFCOUNTERS_H_
+
+#include <array>
+#include <cstdint>
+
+#include "nlohmann/json.hpp"
+using json = nlohmann::json;
+
+namespace CYK{
+
+/// The hardware events that are counted
+enum class PerfEvent { Cycles, Instructions, CacheMisses, BranchMisses };
+
+/// The number of PerfEvents
+constexpr std::size_t perfEventCount = 4;
+
+/// The phases of a parse the hardware events are counted for
+enum class PerfPhase { FirstRow, Splits, Output };
+
+/// The number of PerfPhases
+constexpr std::size_t perfPhaseCount = 3;
+
+/// The counts of the hardware events of a piece of work
+struct PerfSample {
+  /// The counts indexed by PerfEvent, -1 if the event could not be counted
+  std::array<std::int64_t, perfEventCount> counts{-1, -1, -1, -1};
+
+  /// @return The count of an event, -1 if it could not be counted
+  std::int64_t operator[](PerfEvent event) const;
+
+  /// @return The sum of the counts, an event is only counted if it is in both
+  PerfSample operator+(const PerfSample& other) const;
+
+  /// @return The counts and the instructions per cycle as a JSON object, an
+  ///   event that could not be counted is null
+  json toJson() const;
+};
+
+/**
+ * Counts hardware events of the calling thread with Linux perf_event_open
+ *
+ * Only user space is counted, so perf_event_paranoid 2 (the default of most
+ * distributions) is enough. Every event is opened on its own, an event the
+ * CPU or a virtual machine does not support is left out instead of failing
+ * all of them. Counts are scaled when the kernel had to multiplex them.
+ */
+class PerfCounters {
+ private:
+  /// The file descriptor of every event, -1 if it could not be opened
+  std::array<int, perfEventCount> fds{-1, -1, -1, -1};
+
+  /// The counts when start was last called
+  PerfSample begin;
+
+  /// @return The current scaled counts since the counters were opened
+  PerfSample read() const;
+
+ public:
+  /**
+   * Opens and enables the counters for the calling thread
+   * @throws std::runtime_error if no event can be counted, or if it is not
+   *   Linux
+   */
+  PerfCounters();
+
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+
+  ~PerfCounters();
+
+  /// Starts counting a piece of work
+  void start();
+
+  /// @return The counts since start was called
+  PerfSample stop() const;
+
+  /// @return Whether perf_event_open is available on this platform at all
+  static bool isSupported();
+};
+
+/// The counts of every phase of the parses that were recorded
+struct PerfProfile {
+  /// The counts indexed by PerfPhase, starting at 0
+  std::array<PerfSample, perfPhaseCount> phases;
+
+  PerfProfile();
+
+  /// @return The counts of every phase and their "total" as a JSON object
+  json toJson() const;
+};
+
+/**
+ * Counts the phases of the parses on the calling thread into a profile for
+ * as long as it exists. The parsers mark their phases with CYK_PERF_PHASE,
+ * which only checks a thread local pointer while nothing is recorded.
+ */
+class PerfRecording {
+ private:
+  /// The counters of the calling thread
+  PerfCounters& counters;
+
+  /// The profile the phases are added to
+  PerfProfile& profile;
+
+  /// The recording of the thread before this one, restored by the destructor
+  PerfRecording* previous;
+
+  friend class PerfPhaseScope;
+
+ public:
+  /**
+   * Starts recording on the calling thread
+   * @param counters The counters, opened by the calling thread
+   * @param profile The profile the phases are added to
+   */
+  PerfRecording(PerfCounters& counters, PerfProfile& profile);
+
+  PerfRecording(const PerfRecording&) = delete;
+  PerfRecording& operator=(const PerfRecording&) = delete;
+
+  ~PerfRecording();
+
+  /// @return The recording of the calling thread, nullptr if there is none
+  static PerfRecording*& current();
+};
+
+/// Adds the events from its creation to its destruction to a phase of the
+/// recording of the calling thread, if there is one
+class PerfPhaseScope {
+ private:
+  /// The recording of the thread when the scope was created
+  PerfRecording* recording;
+
+  /// The phase the events are added to
+  PerfPhase phase;
+
+ public:
+  /// @param phase The phase the events are added to
+  explicit PerfPhaseScope(PerfPhase phase);
+
+  PerfPhaseScope(const PerfPhaseScope&) = delete;
+  PerfPhaseScope& operator=(const PerfPhaseScope&) = delete;
+
+  ~PerfPhaseScope();
+};
+
+} // namespace CYK
+
+/// Counts the hardware events of the rest of the enclosing scope into a
+/// PerfPhase of the recording of the calling thread
+#define CYK_PERF_PHASE(phase) CYK::PerfPhaseScope cykPerfPhase{phase}
+
+#endif//CYK__PERFCOUNTERS_H_
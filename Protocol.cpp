@@ -0,0 +1,79 @@
+//============================================================================
+// Name        : Protocol.cpp
+// Author      : Tobias Wilfert
+//============================================================================
+
+#include "Protocol.h"
+
+#include <stdexcept>
+
+std::string CYK::Protocol::frame(const std::string &payload) {
+  if(payload.size() > maxPayload){
+    throw std::runtime_error("Message of " + std::to_string(payload.size()) +
+                             " bytes is too long");
+  }
+  const auto length = static_cast<std::uint32_t>(payload.size());
+  std::string framed;
+  framed.reserve(4 + payload.size());
+  for(int b = 0; b < 4; ++b){
+    framed.push_back(static_cast<char>((length >> (8 * b)) & 0xff));
+  }
+  return framed += payload;
+}
+
+bool CYK::Protocol::unframe(const std::string &buffer, std::size_t &offset,
+                            std::string &payload) {
+  if(buffer.size() < offset + 4){ return false; }
+  std::uint32_t length = 0;
+  for(int b = 0; b < 4; ++b){
+    length |= static_cast<std::uint32_t>(
+        static_cast<unsigned char>(buffer[offset + b])) << (8 * b);
+  }
+  if(length > maxPayload){
+    throw std::runtime_error("Message of " + std::to_string(length) +
+                             " bytes is too long");
+  }
+  if(buffer.size() < offset + 4 + length){ return false; }
+  payload.assign(buffer, offset + 4, length);
+  offset += 4 + length;
+  return true;
+}
+
+std::string CYK::Protocol::encode(const CYK::Request &request) {
+  if(request.command == Request::Command::Parse){
+    return "parse\t" + request.grammar + "\t" + std::to_string(request.k) +
+        "\t" + request.input;
+  }
+  return "recognize\t" + request.grammar + "\t" + request.input;
+}
+
+CYK::Request CYK::Protocol::decode(const std::string &payload) {
+  Request request;
+  std::size_t command = payload.find('\t');
+  std::size_t grammar = command == std::string::npos ? command :
+                        payload.find('\t', command + 1);
+  if(grammar == std::string::npos){
+    throw std::invalid_argument("Malformed request");
+  }
+  request.grammar = payload.substr(command + 1, grammar - command - 1);
+  const std::string name = payload.substr(0, command);
+  if(name == "recognize"){
+    request.input = payload.substr(grammar + 1);
+  }else if(name == "parse"){
+    request.command = Request::Command::Parse;
+    std::size_t k = payload.find('\t', grammar + 1);
+    if(k == std::string::npos || k == grammar + 1){
+      throw std::invalid_argument("Malformed parse request");
+    }
+    for(std::size_t c = grammar + 1; c < k; ++c){
+      if(payload[c] < '0' || payload[c] > '9' || k - grammar > 10){
+        throw std::invalid_argument("Malformed parse request");
+      }
+    }
+    request.k = std::stoul(payload.substr(grammar + 1, k - grammar - 1));
+    request.input = payload.substr(k + 1);
+  }else{
+    throw std::invalid_argument("Unknown command \"" + name + "\"");
+  }
+  return request;
+}
@@ -0,0 +1,85 @@
+//============================================================================
+// Name        : Protocol.h
+// Author      : Tobias Wilfert
+//============================================================================
+
+#ifndef CYK__PROTOCOL_H_
+#define CYK__PROTOCOL_H_
+
+#include <string>
+#include <cstdint>
+
+namespace CYK{
+
+/// A request to the recognition server
+struct Request {
+  /// What the server should do with the input
+  enum class Command {
+    /// Only check whether the input is in the language
+    Recognize,
+    /// Also find the k best derivations of the input
+    Parse
+  };
+
+  /// What the server should do with the input
+  Command command = Command::Recognize;
+
+  /// The name of the grammar, empty for the default grammar of the server
+  std::string grammar;
+
+  /// The number of derivations, only used by Command::Parse
+  unsigned int k = 1;
+
+  /// The input string
+  std::string input;
+};
+
+/**
+ * The messages between the recognition server and its clients
+ *
+ * Every message is a frame: a u32 little endian length followed by that many
+ * bytes of payload. The payload of a request is text with tab separated fields:
+ *   "recognize\t<grammar>\t<input>" or "parse\t<grammar>\t<k>\t<input>"
+ * The payload of a response is "accepted" or "rejected", for parse requests
+ * followed by a line "\n<score>\t<tree>" per derivation, or "error\t<message>".
+ * Responses are sent in the order the requests arrived on the connection.
+ */
+class Protocol {
+ public:
+  /// The largest payload that is accepted
+  static constexpr std::uint32_t maxPayload = 1u << 24;
+
+  /**
+   * Puts a payload in a frame
+   * @param payload The payload
+   * @return The length prefix followed by payload
+   */
+  static std::string frame(const std::string& payload);
+
+  /**
+   * Takes the next frame out of received bytes
+   * @param buffer The bytes received so far
+   * @param offset The start of the next frame in buffer, is moved past the
+   *    frame if it is complete
+   * @param payload Is set to the payload of the frame if it is complete
+   * @return Whether buffer holds the complete frame
+   * @throws std::runtime_error if the frame is longer than maxPayload
+   */
+  static bool unframe(const std::string& buffer, std::size_t& offset,
+                      std::string& payload);
+
+  /// @return The payload of request
+  static std::string encode(const Request& request);
+
+  /**
+   * Reads a request from its payload
+   * @param payload The payload
+   * @return The request
+   * @throws std::invalid_argument if the payload is no valid request
+   */
+  static Request decode(const std::string& payload);
+};
+
+} // namespace CYK
+
+#endif//CYK__PROTOCOL_H_
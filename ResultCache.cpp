@@ -0,0 +1,169 @@
+//============================================================================
+// Name        : ResultCache.cpp
+// Author      : Tobias Wilfert
+//============================================================================
+
+#include "ResultCache.h"
+
+#include "Hash.h"
+#include "BitsetParser.h"
+
+namespace {
+
+/// The estimated number of bytes an entry uses besides its input and chart:
+/// the entry itself, its list node and its node and bucket in the index
+constexpr std::size_t entryOverhead = 128;
+
+} // namespace
+
+CYK::ResultCache::ResultCache(std::size_t budget, bool storeCharts,
+                              std::size_t shardCount)
+    : storeCharts(storeCharts) {
+  std::size_t count = 1;
+  while(count < shardCount){ count *= 2; }
+  shards = std::vector<Shard>(count);
+  shardBudget = budget / count;
+}
+
+std::uint64_t CYK::ResultCache::keyHash(std::uint64_t grammar,
+                                        const std::string &input) {
+  return hash(input, hashSeed ^ grammar);
+}
+
+CYK::ResultCache::Shard &CYK::ResultCache::shardOf(std::uint64_t hash) {
+  // The low bits pick the bucket in the index, use the high ones here
+  return shards[(hash >> 48) & (shards.size() - 1)];
+}
+
+CYK::ResultCache::Entry *CYK::ResultCache::find(
+    CYK::ResultCache::Shard &shard, std::uint64_t hash, std::uint64_t grammar,
+    const std::string &input) {
+  auto range = shard.index.equal_range(hash);
+  for(auto it = range.first; it != range.second; ++it){
+    Entry& entry = *it->second;
+    if(entry.grammar == grammar && entry.input == input){
+      shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+      return &entry;
+    }
+  }
+  return nullptr;
+}
+
+void CYK::ResultCache::insert(std::uint64_t hash, std::uint64_t grammar,
+                              const std::string &input, bool accepted,
+                              std::shared_ptr<const CYK::Chart> chart) {
+  std::size_t bytes = entryOverhead + input.size();
+  if(chart){ bytes += chart->getCells().size() * sizeof(std::uint64_t); }
+  if(bytes > shardBudget){ return; } // Would evict everything else
+
+  Shard& shard = shardOf(hash);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  if(Entry* entry = find(shard, hash, grammar, input)){
+    // Another thread parsed the same input in the meantime
+    if(!chart || entry->chart){ return; }
+    shard.bytes -= entry->bytes;
+    entry->chart = std::move(chart);
+    entry->bytes = bytes;
+  }else{
+    shard.entries.push_front({hash, grammar, input, accepted,
+                              std::move(chart), bytes});
+    shard.index.emplace(hash, shard.entries.begin());
+  }
+  shard.bytes += bytes;
+
+  while(shard.bytes > shardBudget){
+    Entry& last = shard.entries.back();
+    auto range = shard.index.equal_range(last.hash);
+    for(auto it = range.first; it != range.second; ++it){
+      if(&*it->second == &last){
+        shard.index.erase(it);
+        break;
+      }
+    }
+    shard.bytes -= last.bytes;
+    shard.entries.pop_back();
+    ++shard.evictions;
+  }
+}
+
+bool CYK::ResultCache::recognize(const CYK::ContextFreeGrammar &grammar,
+                                 const std::string &input) {
+  const std::uint64_t hash = keyHash(grammar.getFingerprint(), input);
+  {
+    Shard& shard = shardOf(hash);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if(Entry* entry = find(shard, hash, grammar.getFingerprint(), input)){
+      ++shard.hits;
+      return entry->accepted;
+    }
+    ++shard.misses;
+  }
+  // Parse without holding the lock, other inputs of the shard can still hit
+  bool accepted;
+  std::shared_ptr<const Chart> chart;
+  if(storeCharts){
+    chart = std::make_shared<const Chart>(grammar.createChart(input));
+    accepted = grammar.getBitsetParser().accepts(*chart);
+  }else{
+    accepted = grammar.recognize(input);
+  }
+  insert(hash, grammar.getFingerprint(), input, accepted, std::move(chart));
+  return accepted;
+}
+
+std::shared_ptr<const CYK::Chart> CYK::ResultCache::chart(
+    const CYK::ContextFreeGrammar &grammar, const std::string &input) {
+  const std::uint64_t hash = keyHash(grammar.getFingerprint(), input);
+  if(storeCharts){
+    Shard& shard = shardOf(hash);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    Entry* entry = find(shard, hash, grammar.getFingerprint(), input);
+    if(entry && entry->chart){
+      ++shard.hits;
+      return entry->chart;
+    }
+    ++shard.misses;
+  }
+  auto chart = std::make_shared<const Chart>(grammar.createChart(input));
+  insert(hash, grammar.getFingerprint(), input,
+         grammar.getBitsetParser().accepts(*chart),
+         storeCharts ? chart : nullptr);
+  return chart;
+}
+
+bool CYK::ResultCache::lookup(const CYK::ContextFreeGrammar &grammar,
+                              const std::string &input, bool &accepted) {
+  const std::uint64_t hash = keyHash(grammar.getFingerprint(), input);
+  Shard& shard = shardOf(hash);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  Entry* entry = find(shard, hash, grammar.getFingerprint(), input);
+  if(!entry){
+    ++shard.misses;
+    return false;
+  }
+  ++shard.hits;
+  accepted = entry->accepted;
+  return true;
+}
+
+void CYK::ResultCache::clear() {
+  for(auto& shard: shards){
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.index.clear();
+    shard.entries.clear();
+    shard.bytes = 0;
+  }
+}
+
+CYK::CacheMetrics CYK::ResultCache::getMetrics() {
+  CacheMetrics metrics;
+  for(auto& shard: shards){
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    metrics.hits += shard.hits;
+    metrics.misses += shard.misses;
+    metrics.evictions += shard.evictions;
+    metrics.entries += shard.entries.size();
+    metrics.bytes += shard.bytes;
+  }
+  return metrics;
+}
@@ -0,0 +1,186 @@
+//============================================================================
+// Name        : ResultCache.h
+// Author      : Tobias Wilfert
+//============================================================================
+
+#ifndef CYK__RESULTCACHE_H_
+#define CYK__RESULTCACHE_H_
+
+#include <list>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+
+#include "Chart.h"
+#include "ContextFreeGrammar.h"
+
+namespace CYK{
+
+/// Statistics of a ResultCache
+struct CacheMetrics {
+  /// The number of lookups that found the input
+  std::size_t hits = 0;
+
+  /// The number of lookups that did not find the input
+  std::size_t misses = 0;
+
+  /// The number of entries that were removed to stay within the budget
+  std::size_t evictions = 0;
+
+  /// The number of entries in the cache
+  std::size_t entries = 0;
+
+  /// The estimated number of bytes used by the entries
+  std::size_t bytes = 0;
+};
+
+/**
+ * Remembers whether inputs are accepted, and optionally their Chart, so
+ * repeated inputs are not parsed again
+ *
+ * The entries are keyed by the fingerprint of the CFG and the input, so one
+ * cache can be shared by several grammars. The cache is split into shards,
+ * each with its own lock and its own least recently used list, the hash of
+ * the key picks the shard and is also the key of the shard's hash map, so a
+ * hit costs one hash of the input plus one lookup. Once the estimated size
+ * of a shard exceeds its part of the budget, its least recently used entries
+ * are removed.
+ */
+class ResultCache {
+ private:
+  /// A cached result
+  struct Entry {
+    /// The hash of the key
+    std::uint64_t hash;
+
+    /// The fingerprint of the CFG
+    std::uint64_t grammar;
+
+    /// The input
+    std::string input;
+
+    /// Whether input is in the language of the CFG
+    bool accepted;
+
+    /// The filled in chart, if charts are stored
+    std::shared_ptr<const Chart> chart;
+
+    /// The estimated number of bytes used by the entry
+    std::size_t bytes;
+  };
+
+  /// Uses the hash of the key as is, it already is one
+  struct Identity {
+    std::size_t operator()(std::uint64_t hash) const {
+      return static_cast<std::size_t>(hash);
+    }
+  };
+
+  /// A part of the cache with its own lock
+  struct Shard {
+    /// Protects the shard
+    std::mutex mutex;
+
+    /// The entries, most recently used first
+    std::list<Entry> entries;
+
+    /// The entries by the hash of their key
+    std::unordered_multimap<std::uint64_t, std::list<Entry>::iterator,
+                            Identity> index;
+
+    /// The estimated number of bytes used by the entries
+    std::size_t bytes = 0;
+
+    /// Counters behind CacheMetrics
+    std::size_t hits = 0, misses = 0, evictions = 0;
+  };
+
+  /// The shards, the number of shards is a power of two
+  std::vector<Shard> shards;
+
+  /// The number of bytes each shard may use
+  std::size_t shardBudget;
+
+  /// Whether the charts of the inputs are stored as well
+  bool storeCharts;
+
+  /**
+   * Get the hash of a key
+   * @param grammar The fingerprint of the CFG
+   * @param input The input
+   * @return The hash
+   */
+  static std::uint64_t keyHash(std::uint64_t grammar, const std::string& input);
+
+  /// @return The shard of a key
+  Shard& shardOf(std::uint64_t hash);
+
+  /**
+   * Finds an entry and marks it as most recently used, shard needs to be locked
+   * @return The entry or nullptr if it is not cached
+   */
+  Entry* find(Shard& shard, std::uint64_t hash, std::uint64_t grammar,
+              const std::string& input);
+
+  /**
+   * Adds or replaces an entry and evicts entries if the shard is too large
+   * @param hash The hash of the key
+   * @param grammar The fingerprint of the CFG
+   * @param input The input
+   * @param accepted Whether input is in the language of the CFG
+   * @param chart The chart of the input, may be nullptr
+   */
+  void insert(std::uint64_t hash, std::uint64_t grammar,
+              const std::string& input, bool accepted,
+              std::shared_ptr<const Chart> chart);
+
+ public:
+  /**
+   * Creates an empty cache
+   * @param budget The (estimated) number of bytes the entries may use
+   * @param storeCharts Whether the charts of the inputs are stored as well
+   * @param shardCount The number of shards, rounded up to a power of two
+   */
+  explicit ResultCache(std::size_t budget, bool storeCharts = false,
+                       std::size_t shardCount = 16);
+
+  /**
+   * Checks whether input is in the language of a CFG, using the cache
+   * @param grammar The CFG
+   * @param input The input string
+   * @return Whether input is in the language of the CFG
+   */
+  bool recognize(const ContextFreeGrammar& grammar, const std::string& input);
+
+  /**
+   * Get the chart of an input, using the cache if charts are stored
+   * @param grammar The CFG
+   * @param input The input string
+   * @return The filled in chart with grammar.getVariables() as its variables
+   */
+  std::shared_ptr<const Chart> chart(const ContextFreeGrammar& grammar,
+                                     const std::string& input);
+
+  /**
+   * Looks up an input without parsing it
+   * @param grammar The CFG
+   * @param input The input string
+   * @param accepted Is set to whether input is accepted if it is cached
+   * @return Whether the input is cached
+   */
+  bool lookup(const ContextFreeGrammar& grammar, const std::string& input,
+              bool& accepted);
+
+  /// Removes all entries, the counters are kept
+  void clear();
+
+  /// @return The statistics of the cache so far
+  CacheMetrics getMetrics();
+};
+
+} // namespace CYK
+
+#endif//CYK__RESULTCACHE_H_
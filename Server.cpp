@@ -0,0 +1,561 @@
+//============================================================================
+// Name        : Server.cpp
+// Author      : Tobias Wilfert
+//============================================================================
+
+#include "Server.h"
+
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+#include <sstream>
+#include <iostream>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/eventfd.h>
+#define CYK_HAS_EPOLL 1
+#endif
+
+#include "BatchParser.h"
+#include "Trace.h"
+
+namespace {
+
+/// @return message followed by the description of errno
+std::string systemError(const std::string& message) {
+  return message + ": " + std::strerror(errno);
+}
+
+/**
+ * Get the epoll data of a socket: the fd with the low 32 bits of the id of
+ * its connection above it. An event that was reported for a connection that
+ * has been closed since (in the same batch of events) then does not match
+ * a new connection that got the same fd.
+ * @param fd The socket
+ * @param id The id of the connection, 0 for the listening socket and wakeFd
+ * @return The data
+ */
+std::uint64_t eventData(int fd, std::uint64_t id) {
+  return (id << 32) | static_cast<std::uint32_t>(fd);
+}
+
+/// The most bytes of responses a client has not read yet before its
+/// connection is not read anymore
+constexpr std::size_t maxUnsent = 1 << 20;
+
+} // namespace
+
+CYK::Server::Server(std::string path, unsigned int workerCount,
+                    const CYK::Batching &batching)
+    : path(std::move(path)), workerCount(std::max(workerCount, 1u)),
+      batching(batching) {
+  this->batching.maxSize = std::max<std::size_t>(batching.maxSize, 1);
+#ifdef CYK_HAS_EPOLL
+  sockaddr_un address{};
+  if(this->path.empty() || this->path.size() >= sizeof(address.sun_path)){
+    throw std::runtime_error("Invalid socket path \"" + this->path + "\"");
+  }
+  address.sun_family = AF_UNIX;
+  std::strcpy(address.sun_path, this->path.c_str());
+
+  // Replace a socket left behind by an earlier server, but nothing else
+  struct stat status{};
+  if(lstat(this->path.c_str(), &status) == 0 && S_ISSOCK(status.st_mode)){
+    unlink(this->path.c_str());
+  }
+
+  listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if(listenFd < 0){ throw std::runtime_error(systemError("socket")); }
+  if(bind(listenFd, reinterpret_cast<sockaddr*>(&address),
+          sizeof(address)) != 0 ||
+     listen(listenFd, SOMAXCONN) != 0){
+    std::string error = systemError("Could not listen on " + this->path);
+    close(listenFd); // Not release, the path may belong to someone else
+    listenFd = -1;
+    throw std::runtime_error(error);
+  }
+  epollFd = epoll_create1(EPOLL_CLOEXEC);
+  wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if(epollFd < 0 || wakeFd < 0){
+    std::string error = systemError("epoll");
+    release();
+    throw std::runtime_error(error);
+  }
+  epoll_event event{};
+  event.events = EPOLLIN;
+  event.data.u64 = eventData(listenFd, 0);
+  epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event);
+  event.data.u64 = eventData(wakeFd, 0);
+  epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+#else
+  throw std::runtime_error("The server is only available on Linux");
+#endif
+}
+
+CYK::Server::~Server() {
+  release();
+}
+
+CYK::GrammarRegistry &CYK::Server::getRegistry() {
+  return registry;
+}
+
+void CYK::Server::setReloadInterval(std::chrono::milliseconds interval) {
+  reloadInterval = interval;
+}
+
+void CYK::Server::setCache(CYK::ResultCache *cache) {
+  this->cache = cache;
+}
+
+void CYK::Server::setLimits(const CYK::ServerLimits &limits) {
+  this->limits = limits;
+}
+
+void CYK::Server::stop() {
+  stopping.store(true);
+#ifdef CYK_HAS_EPOLL
+  std::uint64_t one = 1;
+  // Only async-signal-safe calls from here on
+  if(write(wakeFd, &one, sizeof(one)) < 0){}
+#endif
+}
+
+void CYK::Server::reload() {
+  reloadRequest.store(2);
+#ifdef CYK_HAS_EPOLL
+  std::uint64_t one = 1;
+  if(write(wakeFd, &one, sizeof(one)) < 0){}
+#endif
+}
+
+void CYK::Server::run() {
+#ifdef CYK_HAS_EPOLL
+  {
+    std::lock_guard<std::mutex> lock(taskMutex);
+    workersDone = false;
+  }
+  for(unsigned int w = 0; w < workerCount; ++w){
+    workers.emplace_back(&Server::work, this);
+  }
+  reloadPending = 0;
+  reloader = std::thread(&Server::watch, this);
+
+  epoll_event events[64];
+  while(!stopping.load()){
+    int ready = epoll_wait(epollFd, events, 64, -1);
+    if(ready < 0){
+      if(errno == EINTR){ continue; }
+      break;
+    }
+    for(int e = 0; e < ready; ++e){
+      const int fd = static_cast<int>(events[e].data.u64 & 0xffffffffu);
+      const std::uint64_t id = events[e].data.u64 >> 32;
+      if(fd == listenFd){
+        acceptConnections();
+      }else if(fd == wakeFd){
+        std::uint64_t count;
+        while(read(wakeFd, &count, sizeof(count)) > 0){}
+        if(int request = reloadRequest.exchange(0)){
+          // Hand it to the reloader, this thread keeps serving meanwhile
+          std::lock_guard<std::mutex> lock(reloadMutex);
+          reloadPending = std::max(reloadPending, request);
+          reloadReady.notify_one();
+        }
+        collectResults();
+      }else if(!connections.count(fd) ||
+               (connections.at(fd).id & 0xffffffffu) != id){
+        continue; // Closed by an earlier event of this batch
+      }else if(events[e].events & (EPOLLHUP | EPOLLERR)){
+        closeConnection(fd); // Responses can not be delivered anymore
+      }else{
+        if(events[e].events & EPOLLIN){ readConnection(fd); }
+        if(connections.count(fd) && (events[e].events & EPOLLOUT)){
+          flushConnection(fd);
+        }
+      }
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(taskMutex);
+    workersDone = true;
+    tasks.clear();
+  }
+  taskReady.notify_all();
+  for(auto& worker: workers){ worker.join(); }
+  workers.clear();
+  {
+    std::lock_guard<std::mutex> lock(reloadMutex);
+    reloadPending = -1;
+  }
+  reloadReady.notify_one();
+  reloader.join();
+  while(!connections.empty()){ closeConnection(connections.begin()->first); }
+#endif
+}
+
+void CYK::Server::acceptConnections() {
+#ifdef CYK_HAS_EPOLL
+  for(;;){
+    int fd = accept4(listenFd, nullptr, nullptr,
+                     SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if(fd < 0){ return; } // EAGAIN: no more pending connections
+    const std::uint64_t id = nextConnection++;
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = eventData(fd, id);
+    if(epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) != 0){
+      close(fd);
+      continue;
+    }
+    Connection& connection = connections[fd];
+    connection = Connection{};
+    connection.id = id;
+    connection.events = EPOLLIN;
+  }
+#endif
+}
+
+void CYK::Server::readConnection(int fd) {
+#ifdef CYK_HAS_EPOLL
+  Connection& connection = connections.at(fd);
+  // At most one frame more than it takes, the rest waits in the socket
+  char buffer[65536];
+  while(connection.in.size() - connection.inOffset <
+        Protocol::maxPayload + 4){
+    ssize_t received = read(fd, buffer, sizeof(buffer));
+    if(received > 0){
+      connection.in.append(buffer, received);
+      continue;
+    }
+    if(received < 0 && errno == EINTR){ continue; }
+    if(received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)){
+      connection.closing = true;
+    }
+    break;
+  }
+  takeRequests(fd);
+  writeConnection(fd);
+#endif
+}
+
+void CYK::Server::takeRequests(int fd) {
+  Connection& connection = connections.at(fd);
+  std::size_t room;
+  {
+    std::lock_guard<std::mutex> lock(taskMutex);
+    room = limits.maxQueued - std::min(limits.maxQueued, tasks.size());
+  }
+  std::vector<Task> received;
+  std::string payload;
+  const auto now = std::chrono::steady_clock::now();
+  connection.paused = false;
+  try{
+    for(;;){
+      if(received.size() >= room){
+        connection.paused = queueFull = true;
+        break;
+      }
+      if(connection.nextSequence - connection.nextToSend >= limits.maxPending ||
+         connection.out.size() - connection.outOffset >= maxUnsent){
+        connection.paused = true;
+        break;
+      }
+      if(!Protocol::unframe(connection.in, connection.inOffset, payload)){
+        break;
+      }
+      const std::uint64_t sequence = connection.nextSequence++;
+      try{
+        Request request = Protocol::decode(payload);
+        if(request.input.size() > limits.maxInput){
+          throw std::invalid_argument("The input is longer than " +
+                                      std::to_string(limits.maxInput) +
+                                      " characters");
+        }
+        if(request.command == Request::Command::Parse &&
+           request.k > limits.maxK){
+          throw std::invalid_argument("k is larger than " +
+                                      std::to_string(limits.maxK));
+        }
+        GrammarSnapshot grammar = registry.get(request.grammar);
+        if(!grammar){
+          throw std::invalid_argument("Unknown grammar \"" +
+                                      request.grammar + "\"");
+        }
+        received.push_back({fd, connection.id, sequence, std::move(request),
+                            std::move(grammar), now});
+      }catch(const std::invalid_argument& e){
+        connection.finished[sequence] = std::string("error\t") + e.what();
+      }
+    }
+  }catch(const std::exception& e){
+    // The stream can not be trusted anymore, answer and hang up
+    connection.finished[connection.nextSequence++] =
+        std::string("error\t") + e.what();
+    connection.closing = true;
+    connection.paused = false;
+    connection.in.clear();
+    connection.inOffset = 0;
+  }
+  // Drop the handled bytes once they make up most of the buffer
+  if(connection.inOffset > 0 && connection.inOffset * 2 >= connection.in.size()){
+    connection.in.erase(0, connection.inOffset);
+    connection.inOffset = 0;
+  }
+  if(!received.empty()){
+    {
+      std::lock_guard<std::mutex> lock(taskMutex);
+      for(auto& task: received){ tasks.push_back(std::move(task)); }
+    }
+    taskReady.notify_all();
+  }
+}
+
+void CYK::Server::flushConnection(int fd) {
+  if(writeConnection(fd) && connections.at(fd).paused){
+    takeRequests(fd);
+    writeConnection(fd);
+  }
+}
+
+bool CYK::Server::writeConnection(int fd) {
+#ifdef CYK_HAS_EPOLL
+  Connection& connection = connections.at(fd);
+  // Responses are sent in the order the requests arrived
+  for(auto it = connection.finished.begin();
+      it != connection.finished.end() && it->first == connection.nextToSend;
+      it = connection.finished.erase(it)){
+    connection.out += Protocol::frame(it->second);
+    ++connection.nextToSend;
+  }
+
+  while(connection.outOffset < connection.out.size()){
+    ssize_t sent = send(fd, connection.out.data() + connection.outOffset,
+                        connection.out.size() - connection.outOffset,
+                        MSG_NOSIGNAL);
+    if(sent > 0){
+      connection.outOffset += sent;
+    }else if(sent < 0 && errno == EINTR){
+      continue;
+    }else if(sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)){
+      break;
+    }else{
+      closeConnection(fd);
+      return false;
+    }
+  }
+  if(connection.outOffset == connection.out.size()){
+    connection.out.clear();
+    connection.outOffset = 0;
+  }
+
+  const bool pending = connection.outOffset < connection.out.size();
+  if(connection.closing && !pending && !connection.paused &&
+     connection.nextToSend == connection.nextSequence){
+    closeConnection(fd);
+    return false;
+  }
+  // Only wait for the socket to become writable while there is data left,
+  // and stop reading once the client is done sending or while it is paused
+  std::uint32_t events = 0;
+  if(!connection.closing && !connection.paused){ events |= EPOLLIN; }
+  if(pending){ events |= EPOLLOUT; }
+  if(events != connection.events){
+    epoll_event event{};
+    event.events = events;
+    event.data.u64 = eventData(fd, connection.id);
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &event);
+    connection.events = events;
+  }
+#endif
+  return true;
+}
+
+void CYK::Server::collectResults() {
+  std::vector<Result> done;
+  {
+    std::lock_guard<std::mutex> lock(resultMutex);
+    done.swap(results);
+  }
+  std::vector<int> touched;
+  for(auto& result: done){
+    auto it = connections.find(result.fd);
+    if(it == connections.end() || it->second.id != result.connection){
+      continue; // The client has gone away
+    }
+    it->second.finished[result.sequence] = std::move(result.response);
+    touched.push_back(result.fd);
+  }
+  for(int fd: touched){
+    if(connections.count(fd)){ flushConnection(fd); }
+  }
+  // The workers took tasks, so the connections paused for the queue can go on
+  if(queueFull){
+    queueFull = false;
+    std::vector<int> paused;
+    for(auto& connection: connections){
+      if(connection.second.paused){ paused.push_back(connection.first); }
+    }
+    for(int fd: paused){
+      if(connections.count(fd)){ flushConnection(fd); }
+    }
+  }
+}
+
+void CYK::Server::closeConnection(int fd) {
+#ifdef CYK_HAS_EPOLL
+  epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+  close(fd);
+#endif
+  connections.erase(fd);
+}
+
+void CYK::Server::work() {
+  Trace::nameThread("worker");
+  std::vector<Task> batch;
+  for(;;){
+    batch.clear();
+    {
+      Trace::Span wait{"queue_wait", "server"};
+      std::unique_lock<std::mutex> lock(taskMutex);
+      taskReady.wait(lock, [this](){ return workersDone || !tasks.empty(); });
+      if(workersDone){ return; }
+      // The batch is for the grammar of the oldest request
+      const GrammarSnapshot grammar = tasks.front().grammar;
+      const auto deadline = tasks.front().arrival + batching.maxDelay;
+      for(;;){
+        takeTasks(grammar, batch);
+        if(batch.size() >= batching.maxSize ||
+           std::chrono::steady_clock::now() >= deadline){
+          break;
+        }
+        taskReady.wait_until(lock, deadline);
+        if(workersDone){ return; }
+      }
+    }
+    Trace::Span span{"batch", "server",
+                     static_cast<std::int64_t>(batch.size())};
+    answer(batch);
+  }
+}
+
+void CYK::Server::takeTasks(const CYK::GrammarSnapshot &grammar,
+                            std::vector<CYK::Server::Task> &batch) {
+  auto kept = tasks.begin();
+  for(auto it = tasks.begin(); it != tasks.end(); ++it){
+    if(batch.size() < batching.maxSize && it->grammar == grammar){
+      batch.push_back(std::move(*it));
+    }else{
+      if(kept != it){ *kept = std::move(*it); }
+      ++kept;
+    }
+  }
+  tasks.erase(kept, tasks.end());
+}
+
+void CYK::Server::answer(std::vector<CYK::Server::Task> &batch) {
+  // Keep the version alive even if it is replaced while answering
+  const GrammarSnapshot version = batch.front().grammar;
+  const ContextFreeGrammar& grammar = version->grammar;
+
+  // Identical requests are answered once
+  std::unordered_map<std::string, std::size_t> unique;
+  std::vector<const Request*> requests;
+  std::vector<std::size_t> answerOf;
+  for(auto& task: batch){
+    auto inserted = unique.emplace(Protocol::encode(task.request),
+                                   requests.size());
+    if(inserted.second){ requests.push_back(&task.request); }
+    answerOf.push_back(inserted.first->second);
+  }
+
+  std::vector<std::string> inputs;
+  for(auto request: requests){ inputs.push_back(request->input); }
+  std::vector<std::string> responses;
+  try{
+    std::vector<char> accepted = BatchParser{grammar, 1, cache}.recognize(
+        inputs);
+    for(std::size_t r = 0; r < requests.size(); ++r){
+      std::ostringstream response;
+      response << (accepted[r] ? "accepted" : "rejected");
+      if(requests[r]->command == Request::Command::Parse && accepted[r]){
+        for(auto& derivation: grammar.parse(inputs[r], requests[r]->k)){
+          response << "\n" << derivation.score << "\t" << derivation.tree;
+        }
+      }
+      responses.push_back(response.str());
+    }
+  }catch(const std::exception& e){
+    responses.assign(requests.size(), std::string("error\t") + e.what());
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(resultMutex);
+    for(std::size_t t = 0; t < batch.size(); ++t){
+      results.push_back({batch[t].fd, batch[t].connection, batch[t].sequence,
+                         responses[answerOf[t]]});
+    }
+  }
+  answered.fetch_add(batch.size());
+  batches.fetch_add(1);
+  duplicates.fetch_add(batch.size() - requests.size());
+#ifdef CYK_HAS_EPOLL
+  std::uint64_t one = 1;
+  if(write(wakeFd, &one, sizeof(one)) < 0){}
+#endif
+}
+
+void CYK::Server::watch() {
+  std::unique_lock<std::mutex> lock(reloadMutex);
+  for(;;){
+    if(reloadInterval.count() > 0){
+      reloadReady.wait_for(lock, reloadInterval,
+                           [this](){ return reloadPending != 0; });
+    }else{
+      reloadReady.wait(lock, [this](){ return reloadPending != 0; });
+    }
+    if(reloadPending < 0){ return; }
+    // Without a request it is a periodic check for changed files
+    const bool all = reloadPending == 2;
+    reloadPending = 0;
+    lock.unlock();
+    std::vector<std::string> errors;
+    for(auto& version: registry.reload(all, &errors)){
+      std::cout << "Reloaded " << version->name << " version "
+                << version->version << " from " << version->path << std::endl;
+    }
+    for(auto& error: errors){
+      std::cerr << error << ", keeping the current version" << std::endl;
+    }
+    lock.lock();
+  }
+}
+
+CYK::ServerMetrics CYK::Server::getMetrics() const {
+  ServerMetrics metrics;
+  metrics.requests = answered.load();
+  metrics.batches = batches.load();
+  metrics.duplicates = duplicates.load();
+  return metrics;
+}
+
+void CYK::Server::release() {
+#ifdef CYK_HAS_EPOLL
+  while(!connections.empty()){ closeConnection(connections.begin()->first); }
+  if(listenFd >= 0){
+    close(listenFd);
+    unlink(path.c_str());
+  }
+  if(epollFd >= 0){ close(epollFd); }
+  if(wakeFd >= 0){ close(wakeFd); }
+  listenFd = epollFd = wakeFd = -1;
+#endif
+}
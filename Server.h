@@ -0,0 +1,359 @@
+//============================================================================
+// Name        : Server.h
+// Author      : Tobias Wilfert
+//============================================================================
+
+#ifndef CYK__SERVER_H_
+#define CYK__SERVER_H_
+
+#include <map>
+#include <mutex>
+#include <deque>
+#include <atomic>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+#include <condition_variable>
+
+#include "Protocol.h"
+#include "ResultCache.h"
+#include "GrammarRegistry.h"
+#include "ContextFreeGrammar.h"
+
+namespace CYK{
+
+/**
+ * How the server groups requests, a batch holds requests for the same grammar
+ * and identical requests in a batch are answered once
+ */
+struct Batching {
+  /// The largest number of requests in a batch, 1 turns batching off
+  std::size_t maxSize = 64;
+
+  /// How long a worker waits for more requests after the first request of a
+  /// batch arrived, with 0 a batch only holds the requests already waiting
+  std::chrono::microseconds maxDelay{0};
+};
+
+/**
+ * The most a single request may ask for, the cost of a request grows with
+ * the cube of its input and with k, so they are limited to keep one client
+ * from holding up the workers. Requests over a limit are answered with an
+ * error.
+ */
+struct ServerLimits {
+  /// The longest input of a request
+  std::size_t maxInput = 1024;
+
+  /// The most derivations of a parse request
+  unsigned int maxK = 100;
+
+  /// The most requests of a connection that have not been answered, the
+  /// connection is not read while it has that many
+  std::size_t maxPending = 256;
+
+  /// The most requests waiting for a worker, no connection is read while
+  /// that many are waiting
+  std::size_t maxQueued = 4096;
+};
+
+/// Statistics of a Server
+struct ServerMetrics {
+  /// The number of requests answered by the workers
+  std::size_t requests = 0;
+
+  /// The number of batches the requests were answered in
+  std::size_t batches = 0;
+
+  /// The number of requests that were answered with an identical request
+  std::size_t duplicates = 0;
+};
+
+/**
+ * Serves recognition and parse requests over a Unix domain socket
+ *
+ * The grammars are loaded once, so a request only costs the CYK itself, and
+ * can be reloaded without stopping the server (see GrammarRegistry). A
+ * single thread runs an epoll event loop that accepts connections and reads
+ * and writes the frames (see Protocol), the requests are answered by a pool
+ * of worker threads. A worker answers the waiting requests for a grammar as
+ * one batch (see Batching), which spreads the cost of waking it up and of
+ * handing the responses back over the batch and answers repeated strings
+ * once. Only available on Linux, elsewhere the constructor throws.
+ */
+class Server {
+ private:
+  /// A request waiting for a worker
+  struct Task {
+    /// The connection the request arrived on
+    int fd;
+
+    /// Tells a connection apart from a later one that reuses its fd
+    std::uint64_t connection;
+
+    /// The position of the request on its connection
+    std::uint64_t sequence;
+
+    /// The request
+    Request request;
+
+    /// The version of the grammar that was current when the request was read
+    GrammarSnapshot grammar;
+
+    /// When the request was read
+    std::chrono::steady_clock::time_point arrival;
+  };
+
+  /// A response waiting for the event loop to send it
+  struct Result {
+    /// The fields that identify the request, see Task
+    int fd;
+    std::uint64_t connection;
+    std::uint64_t sequence;
+    std::string response;
+  };
+
+  /// The state of a client connection, only used by the event loop
+  struct Connection {
+    /// The unique id of the connection
+    std::uint64_t id = 0;
+
+    /// The bytes received so far
+    std::string in;
+
+    /// The start of the first frame in in that has not been handled
+    std::size_t inOffset = 0;
+
+    /// The framed responses that still have to be sent
+    std::string out;
+
+    /// The number of bytes of out that have been sent
+    std::size_t outOffset = 0;
+
+    /// The sequence number of the next request
+    std::uint64_t nextSequence = 0;
+
+    /// The sequence number of the next response that is sent
+    std::uint64_t nextToSend = 0;
+
+    /// The responses that are done but have to wait for an earlier one
+    std::map<std::uint64_t, std::string> finished;
+
+    /// Whether the client stopped sending (or sent garbage), the connection
+    /// is closed once all responses have been sent
+    bool closing = false;
+
+    /// Whether requests were left in in because of a limit (see
+    /// ServerLimits), the connection is not read until they are taken
+    bool paused = false;
+
+    /// The events the event loop waits for on the socket
+    std::uint32_t events = 0;
+  };
+
+  /// The path of the socket
+  std::string path;
+
+  /// The grammars
+  GrammarRegistry registry;
+
+  /// How often the files of the grammars are checked for changes, 0 for never
+  std::chrono::milliseconds reloadInterval{0};
+
+  /// Set by reload, 1 to read the changed files, 2 to read all files
+  std::atomic<int> reloadRequest{0};
+
+  /// Reads the files of the grammars again when they change
+  std::thread reloader;
+
+  /// The reload request the reloader handles next
+  int reloadPending = 0;
+
+  /// Protects reloadPending
+  std::mutex reloadMutex;
+
+  /// Wakes the reloader
+  std::condition_variable reloadReady;
+
+  /// The number of worker threads
+  unsigned int workerCount;
+
+  /// How the workers group requests
+  Batching batching;
+
+  /// The most a request may ask for
+  ServerLimits limits;
+
+  /// Remembers the results of earlier requests, may be nullptr
+  ResultCache* cache = nullptr;
+
+  /// Counters behind ServerMetrics
+  std::atomic<std::size_t> answered{0}, batches{0}, duplicates{0};
+
+  /// The listening socket
+  int listenFd = -1;
+
+  /// The epoll instance
+  int epollFd = -1;
+
+  /// An eventfd that wakes the event loop when there are results or on stop
+  int wakeFd = -1;
+
+  /// Set by stop
+  std::atomic<bool> stopping{false};
+
+  /// The open connections by fd, only used by the event loop
+  std::unordered_map<int, Connection> connections;
+
+  /// Whether a connection was paused because tasks was full
+  bool queueFull = false;
+
+  /// The id of the next connection, 0 is the id of the other sockets
+  std::uint64_t nextConnection = 1;
+
+  /// The worker threads
+  std::vector<std::thread> workers;
+
+  /// The requests waiting for a worker
+  std::deque<Task> tasks;
+
+  /// Protects tasks and workersDone
+  std::mutex taskMutex;
+
+  /// Signalled when there are tasks or the workers should stop
+  std::condition_variable taskReady;
+
+  /// Whether the workers should stop
+  bool workersDone = false;
+
+  /// The responses waiting for the event loop
+  std::vector<Result> results;
+
+  /// Protects results
+  std::mutex resultMutex;
+
+  /// Accepts all pending connections
+  void acceptConnections();
+
+  /**
+   * Reads what a client sent and hands the complete requests to the workers
+   * @param fd The connection
+   */
+  void readConnection(int fd);
+
+  /**
+   * Hands the complete requests a client sent to the workers, until the
+   * connection or the queue reaches its limit (see ServerLimits)
+   * @param fd The connection
+   */
+  void takeRequests(int fd);
+
+  /**
+   * Sends the pending responses of a connection and takes the requests that
+   * were left because of a limit
+   * @param fd The connection
+   */
+  void flushConnection(int fd);
+
+  /**
+   * Sends as much of the pending responses of a connection as possible
+   * @param fd The connection
+   * @return False if the connection was closed
+   */
+  bool writeConnection(int fd);
+
+  /// Moves the results of the workers to their connections
+  void collectResults();
+
+  /**
+   * Closes a connection
+   * @param fd The connection
+   */
+  void closeConnection(int fd);
+
+  /// The loop of a worker thread
+  void work();
+
+  /// The loop of the reloader thread
+  void watch();
+
+  /**
+   * Moves the waiting requests for a grammar into a batch, oldest first,
+   * until the batch is full. The caller needs to hold taskMutex.
+   * @param grammar The version of the grammar
+   * @param batch The batch
+   */
+  void takeTasks(const GrammarSnapshot& grammar, std::vector<Task>& batch);
+
+  /**
+   * Answers a batch of requests for the same grammar
+   * @param batch The requests
+   */
+  void answer(std::vector<Task>& batch);
+
+  /// Closes the sockets and removes the socket file
+  void release();
+
+ public:
+  /**
+   * Creates the socket, requests are only answered once run is called
+   * @param path The path of the socket, an existing socket there is replaced
+   * @param workerCount The number of worker threads (at least 1)
+   * @param batching How the workers group requests
+   * @throws std::runtime_error if the socket can not be created
+   */
+  Server(std::string path, unsigned int workerCount,
+         const Batching& batching = {});
+
+  Server(const Server&) = delete;
+  Server& operator=(const Server&) = delete;
+
+  /// Closes all connections and removes the socket
+  ~Server();
+
+  /**
+   * Get the grammars requests can name, the first one added is the default
+   * Grammars can be added and replaced while the server is running, requests
+   * that already arrived keep the version that was current at that time.
+   * @return The grammars
+   */
+  GrammarRegistry& getRegistry();
+
+  /**
+   * Lets the server check the files of the grammars for changes
+   * @param interval The time between two checks, 0 for never
+   */
+  void setReloadInterval(std::chrono::milliseconds interval);
+
+  /**
+   * Lets the workers remember the results of earlier requests
+   * @param cache The cache, needs to outlive the server, nullptr for none
+   */
+  void setCache(ResultCache* cache);
+
+  /// @param limits The most a request may ask for, only before run
+  void setLimits(const ServerLimits& limits);
+
+  /// Answers requests until stop is called
+  void run();
+
+  /// Makes run return, can be called from any thread and from a signal handler
+  void stop();
+
+  /**
+   * Reads the files of all grammars again in the background, grammars whose
+   * file can not be read keep their current version. Can be called from any
+   * thread and from a signal handler.
+   */
+  void reload();
+
+  /// @return The statistics of the server so far
+  ServerMetrics getMetrics() const;
+};
+
+} // namespace CYK
+
+#endif//CYK__SERVER_H_
@@ -0,0 +1,42 @@
+//============================================================================
+// Name        : StreamingRecognizer.cpp
+// Author      : Tobias Wilfert
+//============================================================================
+
+#include "StreamingRecognizer.h"
+
+CYK::StreamingRecognizer::StreamingRecognizer(const ContextFreeGrammar &grammar)
+    : grammar(grammar) {}
+
+bool CYK::StreamingRecognizer::append(char token) {
+  input.push_back(token);
+  const int end = input.size();
+  table.emplace_back();
+  // Every row gets one new cell: the substring of length i+1 ending at token
+  for(int i = 0; i < end; ++i){
+    table[i].push_back(grammar.fillCell(table, input, i, end - i - 1));
+  }
+  return accepts();
+}
+
+bool CYK::StreamingRecognizer::append(const std::string &tokens) {
+  for(char token: tokens){ append(token); }
+  return accepts();
+}
+
+void CYK::StreamingRecognizer::reset() {
+  input.clear();
+  table.clear();
+}
+
+bool CYK::StreamingRecognizer::accepts() const {
+  return grammar.accepts(table);
+}
+
+const std::string &CYK::StreamingRecognizer::getInput() const {
+  return input;
+}
+
+const CYK::Table &CYK::StreamingRecognizer::getTable() const {
+  return table;
+}
@@ -0,0 +1,69 @@
+//============================================================================
+// Name        : StreamingRecognizer.h
+// Author      : Tobias Wilfert
+//============================================================================
+
+#ifndef CYK__STREAMINGRECOGNIZER_H_
+#define CYK__STREAMINGRECOGNIZER_H_
+
+#include <string>
+
+#include "ContextFreeGrammar.h"
+
+namespace CYK{
+
+/**
+ * Recognizes an input that arrives one character at a time
+ *
+ * Appending a character only fills in the cells of the substrings ending at
+ * that character (one new cell per row), so after every character it is known
+ * whether the input received so far is in the language of the CFG.
+ */
+class StreamingRecognizer {
+ private:
+  /// The CFG the input is checked against
+  const ContextFreeGrammar& grammar;
+
+  /// The input received so far
+  std::string input;
+
+  /// The CYK table of the input received so far
+  Table table;
+
+ public:
+  /**
+   * Creates a recognizer with an empty input
+   * @param grammar The CFG, needs to outlive the recognizer
+   */
+  explicit StreamingRecognizer(const ContextFreeGrammar& grammar);
+
+  /**
+   * Appends a character to the input
+   * @param token The character
+   * @return Whether the input (including token) is in the language of the CFG
+   */
+  bool append(char token);
+
+  /**
+   * Appends multiple characters to the input
+   * @param tokens The characters
+   * @return Whether the input (including tokens) is in the language of the CFG
+   */
+  bool append(const std::string& tokens);
+
+  /// Clears the input so a new one can be streamed
+  void reset();
+
+  /// @return Whether the input received so far is in the language of the CFG
+  bool accepts() const;
+
+  /// @return The input received so far
+  const std::string& getInput() const;
+
+  /// @return The CYK table of the input received so far
+  const Table& getTable() const;
+};
+
+} // namespace CYK
+
+#endif//CYK__STREAMINGRECOGNIZER_H_
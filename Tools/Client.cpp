@@ -0,0 +1,241 @@
+//============================================================================
+// Name        : Client.cpp
+// Author      : Tobias Wilfert
+//============================================================================
+
+// Sends strings to a running recognition server (CYK <grammar> --serve=...)
+// and prints the responses, the requests are pipelined over one connection.
+//
+// Usage: cyk_client <socket> [--grammar=<name>] [--kbest=<k>] <string>...
+//
+// With --bench=<requests> the strings are instead sent over and over, from
+// --connections=<c> connections (default 1) that each keep --inflight=<w>
+// requests (default 1) waiting for a response. A JSON line with the
+// throughput and the p50/p99 latency of the requests is printed.
+
+#include <deque>
+#include <chrono>
+#include <cerrno>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+
+#include <unistd.h>
+#include <sys/un.h>
+#include <sys/socket.h>
+
+#include "../Protocol.h"
+
+namespace {
+
+/// Connects to the server
+int connectTo(const std::string& path) {
+  sockaddr_un address{};
+  if(path.size() >= sizeof(address.sun_path)){
+    throw std::runtime_error("Invalid socket path \"" + path + "\"");
+  }
+  address.sun_family = AF_UNIX;
+  std::strcpy(address.sun_path, path.c_str());
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if(fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&address),
+                       sizeof(address)) != 0){
+    const std::string reason = std::strerror(errno);
+    if(fd >= 0){ close(fd); }
+    throw std::runtime_error("Could not connect to " + path + ": " + reason);
+  }
+  return fd;
+}
+
+/// Sends all of data
+void sendAll(int fd, const std::string& data) {
+  for(std::size_t sent = 0; sent < data.size();){
+    ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+    if(n < 0 && errno == EINTR){ continue; }
+    if(n <= 0){ throw std::runtime_error("Connection lost while sending"); }
+    sent += n;
+  }
+}
+
+/// Receives the next response
+std::string receive(int fd, std::string& buffer, std::size_t& offset) {
+  std::string payload;
+  char chunk[65536];
+  while(!CYK::Protocol::unframe(buffer, offset, payload)){
+    ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+    if(n < 0 && errno == EINTR){ continue; }
+    if(n <= 0){ throw std::runtime_error("Connection lost while receiving"); }
+    buffer.append(chunk, n);
+  }
+  return payload;
+}
+
+/// The settings of the benchmark
+struct Bench {
+  std::size_t requests = 0;
+  unsigned int connections = 1;
+  unsigned int inflight = 1;
+};
+
+/**
+ * Sends requests over one connection, keeping inflight of them waiting
+ * @return The latency of every request in microseconds
+ */
+std::vector<double> benchConnection(const std::string& path,
+                                    const std::vector<std::string>& payloads,
+                                    std::size_t requests,
+                                    unsigned int inflight) {
+  using Clock = std::chrono::steady_clock;
+  int fd = connectTo(path);
+  std::vector<double> latencies;
+  std::deque<Clock::time_point> sent;
+  std::string buffer;
+  std::size_t offset = 0;
+  std::size_t next = 0;
+  while(latencies.size() < requests){
+    while(next < requests && sent.size() < std::max(inflight, 1u)){
+      sent.push_back(Clock::now());
+      sendAll(fd, CYK::Protocol::frame(payloads[next++ % payloads.size()]));
+    }
+    std::string response = receive(fd, buffer, offset);
+    if(response.rfind("error\t", 0) == 0){
+      throw std::runtime_error(response.substr(6));
+    }
+    latencies.push_back(std::chrono::duration<double, std::micro>(
+        Clock::now() - sent.front()).count());
+    sent.pop_front();
+    // Drop the handled responses now and then
+    if(offset > 65536){
+      buffer.erase(0, offset);
+      offset = 0;
+    }
+  }
+  close(fd);
+  return latencies;
+}
+
+/// Runs the benchmark and prints the results
+void bench(const std::string& path, const CYK::Request& request,
+           const std::vector<std::string>& inputs, const Bench& settings) {
+  std::vector<std::string> payloads;
+  CYK::Request copy = request;
+  for(auto& input: inputs){
+    copy.input = input;
+    payloads.push_back(CYK::Protocol::encode(copy));
+  }
+  if(payloads.empty()){ throw std::runtime_error("No strings to send"); }
+
+  const unsigned int connections = std::max(settings.connections, 1u);
+  std::vector<std::vector<double>> latencies(connections);
+  std::vector<std::thread> threads;
+  std::vector<std::string> errors(connections);
+  auto start = std::chrono::steady_clock::now();
+  for(unsigned int c = 0; c < connections; ++c){
+    // Spread the requests over the connections
+    std::size_t requests = settings.requests / connections +
+        (c < settings.requests % connections);
+    threads.emplace_back([&, c, requests](){
+      try{
+        latencies[c] = benchConnection(path, payloads, requests,
+                                       settings.inflight);
+      }catch(const std::exception& e){
+        errors[c] = e.what();
+      }
+    });
+  }
+  for(auto& thread: threads){ thread.join(); }
+  double seconds = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  for(auto& error: errors){
+    if(!error.empty()){ throw std::runtime_error(error); }
+  }
+
+  std::vector<double> all;
+  for(auto& part: latencies){ all.insert(all.end(), part.begin(), part.end()); }
+  std::sort(all.begin(), all.end());
+  auto percentile = [&all](double p){
+    return all.empty() ? 0.0 : all[std::min(all.size() - 1,
+        static_cast<std::size_t>(p * all.size()))];
+  };
+  std::cout << "{\"requests\":" << all.size()
+            << ",\"connections\":" << connections
+            << ",\"inflight\":" << settings.inflight
+            << ",\"seconds\":" << seconds
+            << ",\"requests_per_second\":" << all.size() / seconds
+            << ",\"p50_us\":" << percentile(0.50)
+            << ",\"p99_us\":" << percentile(0.99) << "}" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  if(argc < 2){
+    std::cerr << "Usage: " << argv[0]
+              << " <socket> [--grammar=<name>] [--kbest=<k>] [--bench=<n>"
+                 " [--connections=<c>] [--inflight=<w>]] <string>..."
+              << std::endl;
+    return 1;
+  }
+  CYK::Request request;
+  Bench settings;
+  std::vector<std::string> inputs;
+  for(int i = 2; i < argc; ++i){
+    std::string arg = argv[i];
+    if(arg.rfind("--grammar=", 0) == 0){
+      request.grammar = arg.substr(10);
+    }else if(arg.rfind("--bench=", 0) == 0){
+      settings.requests = std::stoul(arg.substr(8));
+    }else if(arg.rfind("--connections=", 0) == 0){
+      settings.connections = std::stoul(arg.substr(14));
+    }else if(arg.rfind("--inflight=", 0) == 0){
+      settings.inflight = std::stoul(arg.substr(11));
+    }else if(arg.rfind("--kbest=", 0) == 0){
+      request.command = CYK::Request::Command::Parse;
+      request.k = std::stoul(arg.substr(8));
+    }else{
+      inputs.push_back(arg);
+    }
+  }
+
+  try{
+    if(settings.requests > 0){
+      bench(argv[1], request, inputs, settings);
+      return 0;
+    }
+    int fd = connectTo(argv[1]);
+    std::string requests;
+    for(auto& input: inputs){
+      request.input = input;
+      requests += CYK::Protocol::frame(CYK::Protocol::encode(request));
+    }
+    sendAll(fd, requests);
+
+    std::string buffer;
+    std::size_t offset = 0;
+    int status = 0;
+    for(auto& input: inputs){
+      std::string response = receive(fd, buffer, offset);
+      if(response.rfind("error\t", 0) == 0){
+        std::cerr << "\"" << input << "\" " << response.substr(6) << std::endl;
+        status = 1;
+        continue;
+      }
+      std::size_t line = response.find('\n');
+      std::cout << "\"" << input << "\" "
+                << (response.rfind("accepted", 0) == 0 ? "Accepted"
+                                                       : "Rejected")
+                << std::endl;
+      if(line != std::string::npos){
+        std::cout << response.substr(line + 1) << std::endl;
+      }
+    }
+    close(fd);
+    return status;
+  }catch(const std::exception& e){
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+}
@@ -0,0 +1,99 @@
+//============================================================================
+// Name        : Generator.cpp
+// Author      : Tobias Wilfert
+//============================================================================
+
+// Generates random grammars in Chomsky normal form and random strings for
+// them, to benchmark and stress test the parsers with inputs of a known size.
+//
+// Usage: cyk_generate grammar [--variables=<n>] [--terminals=<n>]
+//                             [--rules=<n>] [--ambiguity=<0..1>] [--seed=<n>]
+//        cyk_generate inputs <grammar.json> [--count=<n>] [--length=<n>]
+//                            [--rejected] [--seed=<n>]
+//
+// grammar prints a grammar in the format of Grammar.json. inputs prints
+// --count strings of --length characters, one per line, that are in the
+// language of the grammar (sampled from its derivations) or with --rejected
+// that are not.
+
+#include <string>
+#include <fstream>
+#include <iostream>
+
+#include "../GrammarGenerator.h"
+
+int main(int argc, char *argv[]) {
+  const std::string mode = argc > 1 ? argv[1] : "";
+  if(mode != "grammar" && !(mode == "inputs" && argc > 2)){
+    std::cerr << "Usage: " << argv[0]
+              << " grammar [--variables=<n>] [--terminals=<n>] [--rules=<n>]"
+                 " [--ambiguity=<0..1>] [--seed=<n>]\n"
+              << "       " << argv[0]
+              << " inputs <grammar.json> [--count=<n>] [--length=<n>]"
+                 " [--rejected] [--seed=<n>]" << std::endl;
+    return 1;
+  }
+
+  CYK::GrammarShape shape;
+  std::uint64_t seed = 42;
+  std::size_t count = 10;
+  std::size_t length = 16;
+  bool rejected = false;
+  for(int i = mode == "grammar" ? 2 : 3; i < argc; ++i){
+    std::string arg = argv[i];
+    try{
+      if(arg.rfind("--variables=", 0) == 0){
+        shape.variables = std::stoul(arg.substr(12));
+      }else if(arg.rfind("--terminals=", 0) == 0){
+        shape.terminals = std::stoul(arg.substr(12));
+      }else if(arg.rfind("--rules=", 0) == 0){
+        shape.rules = std::stoul(arg.substr(8));
+      }else if(arg.rfind("--ambiguity=", 0) == 0){
+        shape.ambiguity = std::stod(arg.substr(12));
+      }else if(arg.rfind("--seed=", 0) == 0){
+        seed = std::stoull(arg.substr(7));
+      }else if(arg.rfind("--count=", 0) == 0){
+        count = std::stoul(arg.substr(8));
+      }else if(arg.rfind("--length=", 0) == 0){
+        length = std::stoul(arg.substr(9));
+      }else if(arg == "--rejected"){
+        rejected = true;
+      }else{
+        std::cerr << "Unknown argument " << arg << std::endl;
+        return 1;
+      }
+    }catch(const std::logic_error&){
+      std::cerr << "Invalid argument " << arg << std::endl;
+      return 1;
+    }
+  }
+
+  try{
+    CYK::GrammarGenerator generator{seed};
+    if(mode == "grammar"){
+      if(shape.ambiguity < 0 || shape.ambiguity > 1){
+        std::cerr << "The ambiguity has to be between 0 and 1" << std::endl;
+        return 1;
+      }
+      std::cout << generator.grammar(shape).dump(2) << std::endl;
+      return 0;
+    }
+
+    std::ifstream in(argv[2]);
+    if(!in){
+      std::cerr << "Could not open " << argv[2] << std::endl;
+      return 1;
+    }
+    json j;
+    in >> j;
+    CYK::ContextFreeGrammar grammar{j};
+    auto strings = rejected ? generator.rejected(grammar, length, count)
+                            : generator.accepted(grammar, length, count);
+    for(auto& string: strings){ std::cout << string << '\n'; }
+    std::cout.flush();
+  }catch(const std::exception& e){
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,136 @@
+//============================================================================
+// Name        : Trace.cpp
+// Author      : Tobias Wilfert
+//============================================================================
+
+#include "Trace.h"
+
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <algorithm>
+
+#include "nlohmann/json.hpp"
+using json = nlohmann::json;
+
+std::atomic<bool> CYK::Trace::enabled{false};
+
+namespace {
+
+/// A recorded span
+struct Event {
+  const char* name;
+  const char* category;
+  CYK::Trace::Clock::time_point begin;
+  CYK::Trace::Clock::time_point end;
+  std::int64_t argument;
+};
+
+/// The spans of a thread, only written by that thread
+struct Buffer {
+  /// The id of the thread in the trace
+  std::size_t id = 0;
+
+  /// The name of the thread, empty if it has none
+  std::string name;
+
+  /// The ring of spans, next is where the next span goes
+  std::vector<Event> events;
+  std::size_t next = 0;
+
+  /// The number of spans that were recorded in total
+  std::size_t recorded = 0;
+};
+
+/// The state shared by all threads
+struct Registry {
+  std::mutex mutex;
+  std::vector<std::shared_ptr<Buffer>> buffers;
+  std::size_t capacity = 0;
+  CYK::Trace::Clock::time_point origin;
+};
+
+Registry& registry() {
+  static Registry instance;
+  return instance;
+}
+
+/// @return The buffer of the calling thread, created on first use
+Buffer& buffer() {
+  // The registry keeps the buffer so the spans outlive the thread
+  thread_local std::shared_ptr<Buffer> local;
+  if(!local){
+    Registry& shared = registry();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    local = std::make_shared<Buffer>();
+    local->id = shared.buffers.size() + 1;
+    local->events.resize(std::max<std::size_t>(shared.capacity, 1));
+    shared.buffers.push_back(local);
+  }
+  return *local;
+}
+
+} // namespace
+
+void CYK::Trace::start(std::size_t capacity) {
+  Registry& shared = registry();
+  {
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    shared.capacity = capacity;
+    shared.origin = Clock::now();
+  }
+  enabled.store(true);
+}
+
+void CYK::Trace::nameThread(const std::string &name) {
+  if(isEnabled()){ buffer().name = name; }
+}
+
+void CYK::Trace::record(const char *name, const char *category,
+                        CYK::Trace::Clock::time_point begin,
+                        CYK::Trace::Clock::time_point end,
+                        std::int64_t argument) {
+  if(!isEnabled()){ return; }
+  Buffer& local = buffer();
+  local.events[local.next] = {name, category, begin, end, argument};
+  local.next = (local.next + 1) % local.events.size();
+  ++local.recorded;
+}
+
+void CYK::Trace::write(std::ostream &out) {
+  enabled.store(false);
+  Registry& shared = registry();
+  std::lock_guard<std::mutex> lock(shared.mutex);
+  auto micros = [&shared](Clock::duration duration){
+    return std::chrono::duration<double, std::micro>(duration).count();
+  };
+
+  json events = json::array();
+  std::size_t dropped = 0;
+  for(auto& local: shared.buffers){
+    if(!local->name.empty()){
+      events.push_back({{"name", "thread_name"}, {"ph", "M"}, {"pid", 1},
+                        {"tid", local->id},
+                        {"args", {{"name", local->name}}}});
+    }
+    // The oldest span is at next once the ring is full
+    const std::size_t size = local->events.size();
+    const std::size_t count = std::min(local->recorded, size);
+    const std::size_t first = local->recorded > size ? local->next : 0;
+    dropped += local->recorded - count;
+    for(std::size_t e = 0; e < count; ++e){
+      const Event& event = local->events[(first + e) % size];
+      json span{{"name", event.name}, {"cat", event.category}, {"ph", "X"},
+                {"pid", 1}, {"tid", local->id},
+                {"ts", micros(event.begin - shared.origin)},
+                {"dur", micros(event.end - event.begin)}};
+      if(event.argument >= 0){ span["args"] = {{"n", event.argument}}; }
+      events.push_back(std::move(span));
+    }
+  }
+  json trace;
+  trace["traceEvents"] = std::move(events);
+  trace["displayTimeUnit"] = "ns";
+  trace["otherData"] = {{"dropped", dropped}};
+  out << trace.dump() << std::endl;
+}
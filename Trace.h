@@ -0,0 +1,97 @@
+//============================================================================
+// Name        : Trace.h
+// Author      : Tobias Wilfert
+//============================================================================
+
+#ifndef CYK__TRACE_H_
+#define CYK__TRACE_H_
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <cstdint>
+#include <ostream>
+
+namespace CYK{
+
+/**
+ * Records what every thread is doing as spans and writes them in the Chrome
+ * trace event format, which chrome://tracing and Perfetto can show
+ *
+ * Every thread records into its own ring buffer, so recording a span only
+ * reads the clock twice and writes to memory of the thread; once a buffer is
+ * full the oldest spans of that thread are overwritten. The buffers are only
+ * read by write, which has to be called once the traced threads are done.
+ * While tracing is not started a span costs a single relaxed atomic load.
+ */
+class Trace {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+ private:
+  /// Whether spans are recorded
+  static std::atomic<bool> enabled;
+
+ public:
+  /**
+   * Starts recording spans
+   * @param capacity The number of spans every thread keeps
+   */
+  static void start(std::size_t capacity = 1 << 16);
+
+  /// @return Whether spans are recorded
+  static bool isEnabled() {
+    return enabled.load(std::memory_order_relaxed);
+  }
+
+  /// Names the calling thread in the trace
+  static void nameThread(const std::string& name);
+
+  /**
+   * Records a span of the calling thread
+   * @param name The name of the span, needs to stay valid until write
+   * @param category The category of the span, needs to stay valid until write
+   * @param begin When the span began
+   * @param end When the span ended
+   * @param argument A number shown with the span (e.g. the index of the
+   *   input), negative for none
+   */
+  static void record(const char* name, const char* category,
+                     Clock::time_point begin, Clock::time_point end,
+                     std::int64_t argument = -1);
+
+  /**
+   * Stops recording and writes the spans of every thread as a JSON trace
+   * @param out The stream the trace is written to
+   */
+  static void write(std::ostream& out);
+
+  /// Records the time from its creation to its destruction as a span
+  class Span {
+   private:
+    const char* name;
+    const char* category;
+    std::int64_t argument;
+    bool active;
+    Clock::time_point begin;
+
+   public:
+    /// See Trace::record for the parameters
+    Span(const char* name, const char* category, std::int64_t argument = -1)
+        : name(name), category(category), argument(argument),
+          active(isEnabled()) {
+      if(active){ begin = Clock::now(); }
+    }
+
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+    ~Span() {
+      if(active){ record(name, category, begin, Clock::now(), argument); }
+    }
+  };
+};
+
+} // namespace CYK
+
+#endif//CYK__TRACE_H_
@@ -0,0 +1,217 @@
+//============================================================================
+// Name        : WeightedParser.cpp
+// Author      : Tobias Wilfert
+//============================================================================
+
+#include "WeightedParser.h"
+
+#include <cmath>
+#include <algorithm>
+
+bool CYK::WeightedParser::Candidate::operator<(const Candidate &other) const {
+  // Lower scores have a lower priority, ties are broken deterministically
+  if(score != other.score){ return score < other.score; }
+  return std::tie(edge, leftRank, rightRank) >
+      std::tie(other.edge, other.leftRank, other.rightRank);
+}
+
+CYK::WeightedParser::WeightedParser(const Productions &productions,
+                                    const std::string &startSymbol,
+                                    std::string input, const Beam &beam)
+    : productions(productions), startSymbol(startSymbol),
+      input(std::move(input)), beam(beam) {
+  fillTable();
+  for(auto& row: table){ vertices.emplace_back(row.size()); }
+}
+
+void CYK::WeightedParser::fillTable() {
+  const int size = input.size();
+  for(int i = 0; i < size; ++i){
+    table.emplace_back(size - i);
+  }
+  for(int j = 0; j < size; ++j){   // fill in the first row
+    Replacement terminal{std::string{input.at(j)}};
+    for(auto& var: productions.getVariablesThatProduce(terminal)){
+      double weight = productions.getWeight(var, terminal);
+      if(weight > 0){ table[0][j][var] = std::log(weight); }
+    }
+    prune(table[0][j]);
+  }
+  // Fill in the rest of the table, keeping the best score of every variable
+  for(int i = 1; i < size; ++i){
+    for(int j = 0; j < size - i; ++j){ // Looking at (i,j)
+      std::map<std::string, double>& cell = table[i][j];
+      for(int k = 0; k < i; ++k){ // Looking at (k,j) (i-k-1,j+k+1)
+        for(auto& left: table[k][j]){
+          for(auto& right: table[i-k-1][j+k+1]){
+            Replacement rep{left.first, right.first};
+            for(auto& var: productions.getVariablesThatProduce(rep)){
+              double weight = productions.getWeight(var, rep);
+              if(weight <= 0){ continue; }
+              double score = std::log(weight) + left.second + right.second;
+              auto it = cell.find(var);
+              if(it == cell.end()){
+                cell.emplace(var, score);
+              }else if(score > it->second){
+                it->second = score;
+              }
+            }
+          }
+        }
+      }
+      prune(cell);
+    }
+  }
+}
+
+void CYK::WeightedParser::prune(std::map<std::string, double> &cell) {
+  if(beam.width == 0 && std::isinf(beam.threshold)){
+    report.kept += cell.size();
+    return;
+  }
+  if(cell.empty()){ return; }
+  std::vector<std::pair<double, std::string>> ranked;
+  for(auto& entry: cell){ ranked.emplace_back(entry.second, entry.first); }
+  // Best score first, ties in the order of the variables
+  std::stable_sort(ranked.begin(), ranked.end(),
+                   [](const std::pair<double, std::string>& a,
+                      const std::pair<double, std::string>& b){
+                     return a.first > b.first;
+                   });
+  const double cutoff = ranked.front().first - beam.threshold;
+  std::size_t keep = 0;
+  while(keep < ranked.size() &&
+        (beam.width == 0 || keep < beam.width) &&
+        ranked[keep].first >= cutoff){
+    ++keep;
+  }
+  for(std::size_t r = keep; r < ranked.size(); ++r){
+    cell.erase(ranked[r].second);
+  }
+  report.kept += keep;
+  report.pruned += ranked.size() - keep;
+}
+
+CYK::WeightedParser::Vertex &CYK::WeightedParser::getVertex(
+    int i, int j, const std::string &variable) {
+  auto it = vertices[i][j].find(variable);
+  if(it != vertices[i][j].end()){ return it->second; }
+
+  Vertex& vertex = vertices[i][j][variable];
+  // Collect all the edges leading into the vertex
+  for(auto& rep: productions.getReplacements(variable)){
+    double weight = productions.getWeight(variable, rep);
+    if(weight <= 0){ continue; }
+    if(i == 0){
+      if(rep.size() == 1 && rep[0] == std::string{input.at(j)}){
+        vertex.edges.push_back({&rep, 0, std::log(weight)});
+      }
+      continue;
+    }
+    if(rep.size() != 2){ continue; }
+    for(int k = 0; k < i; ++k){
+      if(table[k][j].count(rep[0]) && table[i-k-1][j+k+1].count(rep[1])){
+        vertex.edges.push_back({&rep, k, std::log(weight)});
+      }
+    }
+  }
+  // The initial candidates use the best derivation of each edge's tails
+  for(std::size_t e = 0; e < vertex.edges.size(); ++e){
+    const Edge& edge = vertex.edges[e];
+    double score = edge.score;
+    if(i > 0){
+      const int k = edge.split;
+      score += table[k][j].at(edge.replacement->at(0)) +
+          table[i-k-1][j+k+1].at(edge.replacement->at(1));
+    }
+    vertex.candidates.push({e, 0, 0, score});
+    vertex.seen.emplace(e, 0, 0);
+  }
+  return vertex;
+}
+
+CYK::WeightedParser::Vertex &CYK::WeightedParser::lazyKthBest(
+    int i, int j, const std::string &variable, std::size_t k) {
+  Vertex& vertex = getVertex(i, j, variable);
+  while(vertex.derivations.size() < k){
+    if(!vertex.derivations.empty()){
+      lazyNext(i, j, variable, vertex.derivations.back());
+    }
+    if(vertex.candidates.empty()){ break; }
+    vertex.derivations.push_back(vertex.candidates.top());
+    vertex.candidates.pop();
+  }
+  return vertex;
+}
+
+void CYK::WeightedParser::lazyNext(int i, int j, const std::string &variable,
+                                   const Candidate &candidate) {
+  if(i == 0){ return; } // Terminal derivations have no successors
+  Vertex& vertex = getVertex(i, j, variable);
+  const Edge& edge = vertex.edges[candidate.edge];
+  const int k = edge.split;
+  const std::string& leftVar = edge.replacement->at(0);
+  const std::string& rightVar = edge.replacement->at(1);
+
+  for(int tail = 0; tail < 2; ++tail){
+    std::size_t leftRank = candidate.leftRank + (tail == 0);
+    std::size_t rightRank = candidate.rightRank + (tail == 1);
+    if(vertex.seen.count({candidate.edge, leftRank, rightRank})){ continue; }
+    double leftScore, rightScore;
+    if(!scoreOf(k, j, leftVar, leftRank, leftScore) ||
+       !scoreOf(i-k-1, j+k+1, rightVar, rightRank, rightScore)){
+      continue;
+    }
+    vertex.seen.emplace(candidate.edge, leftRank, rightRank);
+    vertex.candidates.push({candidate.edge, leftRank, rightRank,
+                            edge.score + leftScore + rightScore});
+  }
+}
+
+bool CYK::WeightedParser::scoreOf(int i, int j, const std::string &variable,
+                                  std::size_t rank, double &score) {
+  if(rank == 0){
+    // The best derivation is known from the table, no need to enumerate it
+    score = table[i][j].at(variable);
+    return true;
+  }
+  Vertex& vertex = lazyKthBest(i, j, variable, rank + 1);
+  if(vertex.derivations.size() <= rank){ return false; }
+  score = vertex.derivations[rank].score;
+  return true;
+}
+
+std::string CYK::WeightedParser::tree(int i, int j, const std::string &variable,
+                                      std::size_t rank) {
+  Vertex& vertex = lazyKthBest(i, j, variable, rank + 1);
+  const Candidate candidate = vertex.derivations.at(rank);
+  const Edge& edge = vertex.edges[candidate.edge];
+  if(i == 0){
+    return "(" + variable + " " + edge.replacement->at(0) + ")";
+  }
+  const int k = edge.split;
+  return "(" + variable + " " +
+      tree(k, j, edge.replacement->at(0), candidate.leftRank) + " " +
+      tree(i-k-1, j+k+1, edge.replacement->at(1), candidate.rightRank) + ")";
+}
+
+std::vector<CYK::Derivation> CYK::WeightedParser::best(unsigned int k) {
+  std::vector<Derivation> result;
+  if(input.empty() || !table.back()[0].count(startSymbol)){ return result; }
+
+  const int top = input.size() - 1;
+  Vertex& root = lazyKthBest(top, 0, startSymbol, k);
+  for(std::size_t rank = 0; rank < root.derivations.size(); ++rank){
+    result.push_back({root.derivations[rank].score,
+                      tree(top, 0, startSymbol, rank)});
+  }
+  return result;
+}
+
+const CYK::WeightedTable &CYK::WeightedParser::getTable() const {
+  return table;
+}
+
+const CYK::BeamReport &CYK::WeightedParser::getReport() const {
+  return report;
+}
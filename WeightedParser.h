@@ -0,0 +1,191 @@
+//============================================================================
+// Name        : WeightedParser.h
+// Author      : Tobias Wilfert
+//============================================================================
+
+#ifndef CYK__WEIGHTEDPARSER_H_
+#define CYK__WEIGHTEDPARSER_H_
+
+#include <map>
+#include <set>
+#include <tuple>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include "ContextFreeGrammar.h"
+
+namespace CYK{
+
+/**
+ * The datatype of the weighted CYK table
+ * Every cell maps the variables that can produce the substring to the score
+ * of their best (Viterbi) derivation of that substring
+ */
+using WeightedTable = std::vector<std::vector<std::map<std::string, double>>>;
+
+/**
+ * Finds the k best derivations of an input with the lazy k-best algorithm
+ * ("Algorithm 3" of Huang & Chiang, Better k-best Parsing, 2005)
+ *
+ * The weighted table is filled once, after that the derivations of a
+ * variable over a substring are only enumerated when a better derivation
+ * higher up in the forest asks for them.
+ */
+class WeightedParser {
+ private:
+  /// A production applied to a split of a substring, an edge of the forest
+  struct Edge {
+    /// The production used, only the replacement is needed as the head is known
+    const Replacement* replacement;
+
+    /// The length minus one of the left substring, unused for terminals
+    int split;
+
+    /// The natural logarithm of the weight of the production
+    double score;
+  };
+
+  /// A derivation: an edge together with the rank of the derivations it uses
+  struct Candidate {
+    /// The index of the edge in the edges of the vertex
+    std::size_t edge;
+
+    /// The rank of the derivation of the left variable
+    std::size_t leftRank;
+
+    /// The rank of the derivation of the right variable
+    std::size_t rightRank;
+
+    /// The score of the whole derivation
+    double score;
+
+    /// Orders candidates such that std::priority_queue pops the best first
+    bool operator<(const Candidate& other) const;
+  };
+
+  /// The k-best state of a single variable over a single substring
+  struct Vertex {
+    /// All the ways the variable can produce the substring
+    std::vector<Edge> edges;
+
+    /// The candidates for the next best derivation
+    std::priority_queue<Candidate> candidates;
+
+    /// The candidates that have ever been added, avoids duplicates
+    std::set<std::tuple<std::size_t, std::size_t, std::size_t>> seen;
+
+    /// The derivations found so far, ordered from best to worst
+    std::vector<Candidate> derivations;
+  };
+
+  /// The productions of the CFG
+  const Productions& productions;
+
+  /// The start symbol of the CFG
+  const std::string& startSymbol;
+
+  /// The input that is being parsed
+  std::string input;
+
+  /// The pruning applied to every cell of the table
+  Beam beam;
+
+  /// The statistics of the pruning
+  BeamReport report;
+
+  /// The weighted table for the input
+  WeightedTable table;
+
+  /// The vertices visited so far, indexed like the table
+  std::vector<std::vector<std::map<std::string, Vertex>>> vertices;
+
+  /// Fills in the weighted table
+  void fillTable();
+
+  /**
+   * Removes the variables of a cell that fall outside of the beam
+   * @param cell The cell that should be pruned
+   */
+  void prune(std::map<std::string, double>& cell);
+
+  /**
+   * Get the vertex of a variable over a substring, initializing it if needed
+   * @param i The row of the substring (its length minus one)
+   * @param j The column of the substring (its start)
+   * @param variable The variable
+   * @return The vertex of variable at (i,j)
+   */
+  Vertex& getVertex(int i, int j, const std::string& variable);
+
+  /**
+   * Makes sure that the first k derivations of a vertex have been found
+   * or that all of its derivations have been found if there are less than k
+   * @param i The row of the vertex
+   * @param j The column of the vertex
+   * @param variable The variable of the vertex
+   * @param k The number of derivations that are needed
+   * @return The vertex
+   */
+  Vertex& lazyKthBest(int i, int j, const std::string& variable, std::size_t k);
+
+  /**
+   * Adds the successors of a derivation of a vertex to its candidates
+   * @param i The row of the vertex
+   * @param j The column of the vertex
+   * @param variable The variable of the vertex
+   * @param candidate The derivation whose successors should be added
+   */
+  void lazyNext(int i, int j, const std::string& variable,
+                const Candidate& candidate);
+
+  /**
+   * Get the score of the derivation with a certain rank of a vertex
+   * @param i The row of the vertex
+   * @param j The column of the vertex
+   * @param variable The variable of the vertex
+   * @param rank The rank of the derivation
+   * @param score Is set to the score of the derivation if it exists
+   * @return Whether the vertex has a derivation with rank rank
+   */
+  bool scoreOf(int i, int j, const std::string& variable, std::size_t rank,
+               double& score);
+
+  /**
+   * Creates the bracketed representation of a derivation
+   * @param i The row of the vertex
+   * @param j The column of the vertex
+   * @param variable The variable of the vertex
+   * @param rank The rank of the derivation
+   * @return The parse tree in bracketed form
+   */
+  std::string tree(int i, int j, const std::string& variable, std::size_t rank);
+
+ public:
+  /**
+   * Fills in the weighted table for input
+   * @param productions The productions of the CFG
+   * @param startSymbol The start symbol of the CFG
+   * @param input The input that should be parsed
+   * @param beam The pruning that should be applied to every cell
+   */
+  WeightedParser(const Productions& productions, const std::string& startSymbol,
+                 std::string input, const Beam& beam = {});
+
+  /**
+   * Get the k best derivations of the input
+   * @param k The (maximum) number of derivations
+   * @return The derivations ordered from best to worst
+   */
+  std::vector<Derivation> best(unsigned int k);
+
+  /// @return The weighted table of the input
+  const WeightedTable& getTable() const;
+
+  /// @return The statistics of the pruning done while filling the table
+  const BeamReport& getReport() const;
+};
+
+} // namespace CYK
+
+#endif//CYK__WEIGHTEDPARSER_H_
@@ -1,5 +1,459 @@
+#include <cmath>
+#include <csignal>
+#include <optional>
 #include <iostream>
+#include <stdexcept>
+#include "Chart.h"
+#include "ChartFile.h"
+#include "Server.h"
+#include "OutputSink.h"
+#include "Trace.h"
+#include "Memory.h"
+#include "BitsetParser.h"
+#include "PerfCounters.h"
+#include "BatchParser.h"
+#include "Instrumentation.h"
 #include "ContextFreeGrammar.h"
+#include "StreamingRecognizer.h"
+
+namespace {
+
+/// The command line options, they start with "--" and apply to all strings
+struct Options {
+  unsigned int kBest = 0;
+  CYK::Beam beam;
+  bool stream = false;
+  bool perf = false;
+  unsigned int threads = 0;
+  unsigned int writers = 1;
+  std::size_t queue = 64;
+  std::string serve;
+  unsigned int workers = std::thread::hardware_concurrency();
+  CYK::Batching batching;
+  CYK::ServerLimits limits;
+  std::size_t cacheBudget = 0;
+  bool memory = false;
+  std::size_t memoryBudget = 0;
+  std::string overBudget = "refuse";
+  std::chrono::milliseconds reloadInterval{0};
+  std::vector<std::pair<std::string, std::string>> grammars;
+  std::string spansOf;
+  std::string trace;
+  std::string format = "html";
+  CYK::SinkOptions sink;
+  std::vector<std::string> charts;
+  std::vector<std::string> inputs;
+};
+
+/// @return The name of a grammar file without directories and extension
+std::string grammarName(const std::string &path) {
+  std::size_t begin = path.find_last_of("/\\");
+  begin = begin == std::string::npos ? 0 : begin + 1;
+  std::size_t end = path.rfind('.');
+  if (end == std::string::npos || end < begin) { end = path.size(); }
+  return path.substr(begin, end - begin);
+}
+
+/// The running server, stopped by SIGINT and SIGTERM
+CYK::Server *server = nullptr;
+
+extern "C" void stopServer(int) {
+  if (server) { server->stop(); }
+}
+
+extern "C" void reloadServer(int) {
+  if (server) { server->reload(); }
+}
+
+/// Prints the statistics of a result cache
+void printCache(CYK::ResultCache &cache) {
+  CYK::CacheMetrics metrics = cache.getMetrics();
+  std::cout << "Cache: " << metrics.hits << " hits, " << metrics.misses
+            << " misses, " << metrics.evictions << " evictions, "
+            << metrics.entries << " entries using " << metrics.bytes
+            << " bytes" << std::endl;
+}
+
+/// Serves requests for the grammars until SIGINT or SIGTERM, SIGHUP reloads
+/// the grammars
+void serve(const std::string &path, const Options &options) {
+  CYK::Server instance{options.serve, options.workers, options.batching};
+  instance.getRegistry().load(grammarName(path), path);
+  for (auto &named : options.grammars) {
+    instance.getRegistry().load(named.first, named.second);
+  }
+  instance.setReloadInterval(options.reloadInterval);
+  instance.setLimits(options.limits);
+  CYK::ResultCache cache{options.cacheBudget};
+  if (options.cacheBudget > 0) { instance.setCache(&cache); }
+  server = &instance;
+  std::signal(SIGINT, stopServer);
+  std::signal(SIGTERM, stopServer);
+#ifdef SIGHUP
+  std::signal(SIGHUP, reloadServer);
+#endif
+  std::cout << "Serving on " << options.serve << std::endl;
+  instance.run();
+  server = nullptr;
+  CYK::ServerMetrics metrics = instance.getMetrics();
+  std::cout << "Stopped serving, answered " << metrics.requests
+            << " requests in " << metrics.batches << " batches, "
+            << metrics.duplicates << " of them duplicates" << std::endl;
+  if (options.cacheBudget > 0) { printCache(cache); }
+}
+
+/// Parses the arguments after the path of the grammar
+Options parseOptions(int argc, char *argv[]) {
+  Options options;
+  bool outputFile = false, beamThreshold = false;
+  for (int i = 2; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg.rfind("--kbest=", 0) == 0) {
+      options.kBest = std::stoul(arg.substr(8));
+    } else if (arg.rfind("--beam=", 0) == 0) {
+      options.beam.width = std::stoul(arg.substr(7));
+    } else if (arg.rfind("--beam-threshold=", 0) == 0) {
+      options.beam.threshold = std::stod(arg.substr(17));
+      beamThreshold = true;
+    } else if (arg.rfind("--spans=", 0) == 0) {
+      options.spansOf = arg.substr(8);
+    } else if (arg.rfind("--output=", 0) == 0) {
+      options.format = arg.substr(9);
+    } else if (arg.rfind("--output-file=", 0) == 0) {
+      options.sink.path = arg.substr(14);
+      outputFile = true;
+    } else if (arg == "--name-by-hash") {
+      options.sink.hashNames = true;
+    } else if (arg.rfind("--html-window=", 0) == 0) {
+      CYK::HTMLView &view = options.sink.view;
+      view.mode = CYK::HTMLView::Mode::Window;
+      std::size_t colon = arg.find(':', 14);
+      view.begin = std::stoul(arg.substr(14, colon - 14));
+      if (colon != std::string::npos) {
+        view.end = std::stoul(arg.substr(colon + 1));
+      }
+    } else if (arg.rfind("--html-heatmap=", 0) == 0) {
+      options.sink.view.mode = CYK::HTMLView::Mode::Heatmap;
+      options.sink.view.resolution = std::stoul(arg.substr(15));
+    } else if (arg == "--html-derivation") {
+      options.sink.view.mode = CYK::HTMLView::Mode::Derivation;
+    } else if (arg.rfind("--load=", 0) == 0) {
+      options.charts.push_back(arg.substr(7));
+    } else if (arg == "--stream") {
+      options.stream = true;
+    } else if (arg.rfind("--trace=", 0) == 0) {
+      options.trace = arg.substr(8);
+    } else if (arg == "--perf") {
+      options.perf = true;
+    } else if (arg.rfind("--threads=", 0) == 0) {
+      options.threads = std::stoul(arg.substr(10));
+    } else if (arg.rfind("--writers=", 0) == 0) {
+      options.writers = std::stoul(arg.substr(10));
+    } else if (arg.rfind("--queue=", 0) == 0) {
+      options.queue = std::stoul(arg.substr(8));
+    } else if (arg.rfind("--serve=", 0) == 0) {
+      options.serve = arg.substr(8);
+    } else if (arg.rfind("--workers=", 0) == 0) {
+      options.workers = std::stoul(arg.substr(10));
+    } else if (arg.rfind("--batch=", 0) == 0) {
+      options.batching.maxSize = std::stoul(arg.substr(8));
+    } else if (arg.rfind("--batch-delay=", 0) == 0) {
+      options.batching.maxDelay = std::chrono::microseconds{
+          std::stoul(arg.substr(14))};
+    } else if (arg.rfind("--max-input=", 0) == 0) {
+      options.limits.maxInput = std::stoul(arg.substr(12));
+    } else if (arg.rfind("--max-k=", 0) == 0) {
+      options.limits.maxK = std::stoul(arg.substr(8));
+    } else if (arg.rfind("--max-pending=", 0) == 0) {
+      options.limits.maxPending = std::max(1ul, std::stoul(arg.substr(14)));
+    } else if (arg.rfind("--max-queued=", 0) == 0) {
+      options.limits.maxQueued = std::max(1ul, std::stoul(arg.substr(13)));
+    } else if (arg.rfind("--reload-interval=", 0) == 0) {
+      options.reloadInterval = std::chrono::milliseconds{
+          std::stoul(arg.substr(18))};
+    } else if (arg.rfind("--cache=", 0) == 0) {
+      options.cacheBudget = std::stoul(arg.substr(8)) << 20;
+    } else if (arg == "--memory") {
+      options.memory = true;
+    } else if (arg.rfind("--memory-budget=", 0) == 0) {
+      options.memoryBudget = std::stoul(arg.substr(16)) << 20;
+    } else if (arg.rfind("--over-budget=", 0) == 0) {
+      options.overBudget = arg.substr(14);
+    } else if (arg.rfind("--grammar=", 0) == 0) {
+      std::size_t equals = arg.find('=', 10);
+      if (equals == std::string::npos) {
+        options.grammars.emplace_back(grammarName(arg.substr(10)),
+                                      arg.substr(10));
+      } else {
+        options.grammars.emplace_back(arg.substr(10, equals - 10),
+                                      arg.substr(equals + 1));
+      }
+    } else {
+      options.inputs.push_back(arg);
+    }
+  }
+  if (options.kBest == 0 && (options.beam.width > 0 ||
+                             !std::isinf(options.beam.threshold))) {
+    throw std::invalid_argument("--beam and --beam-threshold need --kbest");
+  }
+  if (beamThreshold && !(std::isfinite(options.beam.threshold) &&
+                         options.beam.threshold > 0)) {
+    throw std::invalid_argument("--beam-threshold must be a positive number");
+  }
+  // --perf only counts the events of the plain CYK of every string
+  if (options.perf &&
+      (options.threads > 0 || options.kBest > 0 ||
+       !options.spansOf.empty() || options.memory ||
+       options.memoryBudget > 0)) {
+    throw std::invalid_argument(
+        "--perf can not be combined with --threads, --kbest, --spans, "
+        "--memory or --memory-budget");
+  }
+  // Batch mode only recognizes the strings and writes their tables
+  if (options.threads > 0 &&
+      (options.kBest > 0 || !options.spansOf.empty() ||
+       options.memoryBudget > 0)) {
+    throw std::invalid_argument(
+        "--threads can not be combined with --kbest, --spans or "
+        "--memory-budget");
+  }
+  // Only results are cached, the tables of the output are not
+  if (options.cacheBudget > 0 && options.serve.empty() &&
+      (options.threads == 0 || options.format != "none")) {
+    throw std::invalid_argument(
+        "--cache needs --serve, or --threads with --output=none");
+  }
+  if (!outputFile) {
+    const std::string &format = options.format;
+    options.sink.path = format == "json"        ? "CYKTables.jsonl"
+                        : format == "binary"    ? "CYKTables.bin"
+                        : format == "container" ? "CYKTables.cykc"
+                                                : "CYKTables." + format;
+  }
+  return options;
+}
+
+/// Hands a chart that was loaded from a file to the sink
+void writeChart(const CYK::MappedChart &chart, const std::string &path,
+                CYK::OutputSink &sink) {
+  std::cout << "Loaded \"" << chart.getInput() << "\" from " << path
+            << std::endl;
+  sink.write(chart.getInput(), chart.toChart().toTable(), chart.isAccepted());
+  std::cout << (chart.isAccepted() ? "Accepted" : "Rejected") << std::endl;
+}
+
+/// Runs the recognizer on stdin, every line is a string
+void streamInput(const CYK::ContextFreeGrammar &grammar) {
+  CYK::StreamingRecognizer recognizer{grammar};
+  char token;
+  while (std::cin.get(token)) {
+    if (token == '\n') {
+      recognizer.reset();
+      continue;
+    }
+    if (token == '\r') { continue; }
+    bool accepted = recognizer.append(token);
+    std::cout << recognizer.getInput().size() << "\t" << token << "\t"
+              << (accepted ? "accepted" : "rejected") << std::endl;
+  }
+}
+
+/// Runs the CYK on a string within the --memory-budget and prints the memory
+/// it needed. Sinks that only need a chart get the one of the BitsetParser.
+/// If a Table could exceed the budget the string is refused or, with
+/// --over-budget=lean, recognized by the BitsetParser without output.
+/// @return Whether the string was accepted, nothing if it was refused
+std::optional<bool> recognizeAccounted(const CYK::ContextFreeGrammar &grammar,
+                                       const std::string &input,
+                                       const Options &options,
+                                       CYK::OutputSink &sink) {
+  const CYK::MemoryEstimate estimate =
+      CYK::Memory::estimate(grammar, input.size());
+  const std::size_t budget = options.memoryBudget;
+  const CYK::BitsetParser &parser = grammar.getBitsetParser();
+  std::string engine = sink.usesChart() ? "bitset" : "table";
+  if (budget > 0 && engine == "table" &&
+      estimate.grammarBytes + estimate.tableBytes > budget) {
+    engine = options.overBudget == "lean" ? "bitset" : "refused";
+  }
+  if (budget > 0 && engine == "bitset" &&
+      estimate.grammarBytes + estimate.chartBytes +
+              parser.getRowBytes(input.size()) > budget) {
+    engine = "refused";
+  }
+
+  json report;
+  report["length"] = input.size();
+  report["cells"] = estimate.cells;
+  report["grammar_bytes"] = estimate.grammarBytes;
+  report["estimated_table_bytes"] = estimate.tableBytes;
+  report["estimated_chart_bytes"] = estimate.chartBytes;
+  report["engine"] = engine;
+  CYK::MemoryMeter &meter = CYK::MemoryMeter::global();
+  std::optional<bool> accepted;
+  std::size_t bytes = 0;
+  // The estimate is reserved while the table or chart is alive, so the peak
+  // covers the whole fill, and the measured size is reported
+  if (engine == "table") {
+    const CYK::MemoryReservation reservation(meter, estimate.tableBytes);
+    CYK::Table table = grammar.fillTable(input);
+    bytes = CYK::Memory::bytesOf(table);
+    accepted = grammar.accepts(table);
+    sink.write(input, table, *accepted);
+  } else if (engine == "bitset") {
+    const CYK::MemoryReservation reservation(
+        meter, estimate.chartBytes + parser.getRowBytes(input.size()));
+    const CYK::Chart &chart = parser.fill(input, CYK::ParserContext::local());
+    bytes = CYK::Memory::bytesOf(chart) + parser.getRowBytes(input.size());
+    accepted = parser.accepts(chart);
+    if (sink.usesChart()) { sink.writeChart(input, chart, *accepted); }
+  }
+  if (accepted) {
+    report["bytes"] = bytes;
+    report["bytes_per_cell"] =
+        estimate.cells == 0 ? 0.0 : static_cast<double>(bytes) / estimate.cells;
+  }
+  std::cout << "Memory " << report.dump() << std::endl;
+  return accepted;
+}
+
+/// Simulates the CYK on a single string
+void simulate(CYK::ContextFreeGrammar &grammar, const std::string &input,
+              const Options &options, CYK::OutputSink &sink) {
+  std::cout << "Now simulating \"" << input << "\"" << std::endl;
+  std::optional<bool> accepted;
+  if (options.memory || options.memoryBudget > 0) {
+    accepted = recognizeAccounted(grammar, input, options, sink);
+  } else {
+    accepted = grammar.CYK(input, sink);
+  }
+  if (!accepted) {
+    std::cout << "Refused, a table could exceed the memory budget of "
+              << options.memoryBudget << " bytes" << std::endl;
+    std::cout << "Finished simulating" << std::endl;
+    return;
+  }
+  std::cout << (*accepted ? "Accepted" : "Rejected") << std::endl;
+  if (CYK::Instrumentation::enabled) {
+    std::cout << "Profile " << CYK::Instrumentation::current().toJson().dump()
+              << std::endl;
+  }
+  if (options.kBest > 0) {
+    CYK::BeamReport report;
+    for (auto &derivation :
+         grammar.parse(input, options.kBest, options.beam, &report)) {
+      std::cout << derivation.score << "\t" << derivation.tree << std::endl;
+    }
+    if (options.beam.width > 0 || !std::isinf(options.beam.threshold)) {
+      std::cout << "Beam kept " << report.kept << " and pruned "
+                << report.pruned << " variables" << std::endl;
+    }
+  }
+  if (!options.spansOf.empty()) {
+    CYK::Chart chart = grammar.createChart(input);
+    long symbol = chart.symbolIndex(options.spansOf);
+    if (symbol >= 0) {
+      for (auto &span : chart.maximalSpans(symbol)) {
+        std::cout << options.spansOf << " produces [" << span.first << ", "
+                  << span.second << ") \""
+                  << input.substr(span.first, span.second - span.first)
+                  << "\"" << std::endl;
+      }
+    }
+  }
+  std::cout << "Finished simulating" << std::endl;
+}
+
+/// Simulates the CYK on a single string counting the hardware events of
+/// every phase: the first row, the other rows (the splits) and the output
+void simulatePerf(CYK::ContextFreeGrammar &grammar,
+                  const std::string &input, CYK::PerfCounters &counters,
+                  CYK::OutputSink &sink) {
+  CYK::PerfProfile profile;
+  bool accepted;
+  {
+    CYK::PerfRecording recording{counters, profile};
+    accepted = grammar.CYK(input, sink);
+  }
+
+  json report;
+  report["input"] = input;
+  report["length"] = input.size();
+  report["accepted"] = accepted;
+  report["phases"] = profile.toJson();
+  std::cout << "Perf " << report.dump() << std::endl;
+}
+
+/// Runs the CYK on all strings at once, the tables are written asynchronously
+void simulateBatch(const CYK::ContextFreeGrammar &grammar,
+                   const Options &options, CYK::OutputSink &sink) {
+  CYK::OutputPipeline pipeline{sink, options.writers, options.queue};
+  // Without output only the results are needed, those can be cached
+  const bool cached = options.cacheBudget > 0;
+  CYK::ResultCache cache{options.cacheBudget};
+  CYK::BatchParser parser{grammar, options.threads, cached ? &cache : nullptr};
+  std::vector<char> accepted =
+      parser.recognize(options.inputs, cached ? nullptr : &pipeline);
+  pipeline.close();
+  for (std::size_t n = 0; n < options.inputs.size(); ++n) {
+    std::cout << "\"" << options.inputs[n] << "\" "
+              << (accepted[n] ? "Accepted" : "Rejected") << std::endl;
+  }
+  CYK::PipelineMetrics metrics = pipeline.getMetrics();
+  std::cout << "Wrote " << metrics.written << " of " << metrics.submitted
+            << " tables, queue depth average " << metrics.averageDepth
+            << " max " << metrics.maxDepth << ", " << metrics.stalls
+            << " parser stalls" << std::endl;
+  if (cached) { printCache(cache); }
+}
+
+/// Prints the most memory the tables used at once, with --memory
+void printMemory(const CYK::ContextFreeGrammar &grammar,
+                 const Options &options) {
+  if (!options.memory) { return; }
+  std::cout << "Memory peak " << CYK::MemoryMeter::global().getPeak()
+            << " bytes of tables, the grammar uses "
+            << CYK::Memory::bytesOf(grammar) << " bytes" << std::endl;
+}
+
+/// The length of the start of the longest input the tiles are tuned on
+constexpr std::size_t tuneLength = 512;
+
+/// Tunes the tiles the table is filled in with the start of the longest
+/// input, if a table is built for it. Tuning fills in the table of the start
+/// a few times, so it is only done for inputs of at least four times its
+/// length, where that is a small part of the time of the parse; shorter ones
+/// use the default tile size.
+void tuneTiles(CYK::ContextFreeGrammar &grammar, const Options &options,
+               const CYK::OutputSink &sink) {
+  if (sink.usesChart()) { return; }
+  std::size_t longest = 0;
+  for (std::size_t n = 1; n < options.inputs.size(); ++n) {
+    if (options.inputs[n].size() > options.inputs[longest].size()) {
+      longest = n;
+    }
+  }
+  if (options.inputs.empty() ||
+      options.inputs[longest].size() < 4 * tuneLength) {
+    return;
+  }
+  const std::size_t tile =
+      grammar.tune(options.inputs[longest].substr(0, tuneLength));
+  std::cout << "Filling the tables "
+            << (tile == 0 ? "by diagonal"
+                          : "in tiles of " + std::to_string(tile))
+            << std::endl;
+}
+
+/// Writes the spans recorded since the start to the --trace file
+void writeTrace(const Options &options) {
+  if (options.trace.empty()) { return; }
+  std::ofstream out(options.trace);
+  if (!out) { throw std::runtime_error("Could not open " + options.trace); }
+  CYK::Trace::write(out);
+}
+
+} // namespace
 
 int main(int argc, char *argv[]) {
   json j;
@@ -7,10 +461,59 @@ int main(int argc, char *argv[]) {
   ifs >> j;
   CYK::ContextFreeGrammar grammar{j};
 
-  for (int i = 2; i < argc; ++i) {
-    std::cout << "Now simulating \"" << argv[i] << "\"" << std::endl;
-    grammar.CYK(argv[i]);
-    std::cout << "Finished simulating" << std::endl;
+  try {
+    const Options options = parseOptions(argc, argv);
+    std::unique_ptr<CYK::OutputSink> sink =
+        CYK::OutputSink::create(options.format, grammar, options.sink);
+    if (!sink) {
+      std::cerr << "Unknown output format \"" << options.format << "\""
+                << std::endl;
+      return 1;
+    }
+    if (!options.trace.empty()) { CYK::Trace::start(); }
+    if (options.memory || options.memoryBudget > 0) {
+      CYK::MemoryMeter::global().enable();
+    }
+
+    // Archived charts are handed to the sink without parsing them again
+    for (auto &path : options.charts) {
+      if (CYK::MappedContainer::isContainer(path)) {
+        CYK::MappedContainer container{path};
+        for (std::size_t r = 0; r < container.size(); ++r) {
+          writeChart(container.record(r), path, *sink);
+        }
+      } else {
+        writeChart(CYK::MappedChart{path}, path, *sink);
+      }
+    }
+
+    if (!options.serve.empty()) {
+      serve(argv[1], options);
+      printMemory(grammar, options);
+      writeTrace(options);
+      return 0;
+    }
+
+    if (options.stream) { streamInput(grammar); }
+    tuneTiles(grammar, options, *sink);
+
+    if (options.perf) {
+      CYK::PerfCounters counters;
+      for (auto &input : options.inputs) {
+        simulatePerf(grammar, input, counters, *sink);
+      }
+    } else if (options.threads > 0) {
+      simulateBatch(grammar, options, *sink);
+    } else {
+      for (auto &input : options.inputs) {
+        simulate(grammar, input, options, *sink);
+      }
+    }
+    printMemory(grammar, options);
+    writeTrace(options);
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
   }
   return 0;
-}
\ No newline at end of file
+}
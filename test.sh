@@ -1,3 +1,4 @@
 cd build
 ./CYK ../Grammar.json abbc cbcbcbccbc cbccbc bcbbcbbbccbcbccb
+./cyk_bench --verify > /dev/null || echo "The BitsetParser and fillTable disagree"
 cd ..